@@ -0,0 +1,81 @@
+/**
+ * @file bej_cache.h
+ * @brief Content-addressed LRU cache of rendered conversion results
+ */
+
+#ifndef BEJ_CACHE_H
+#define BEJ_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Opaque cache handle */
+struct bej_cache;
+
+/** Cache counters */
+struct bej_cache_stats {
+    uint64_t hits;       /**< Lookups answered from the cache */
+    uint64_t misses;     /**< Lookups that required a full conversion */
+    uint64_t evictions;  /**< Entries dropped to respect the cache bounds */
+    size_t entries;      /**< Entries currently cached */
+    size_t bytes;        /**< Input plus output bytes currently cached */
+};
+
+/**
+ * @brief Fast 64-bit hash (XXH64 construction, little-endian loads)
+ * @param data Bytes to hash
+ * @param len Number of bytes
+ * @param seed Hash seed
+ * @return 64-bit hash value
+ */
+uint64_t bej_hash64(const void *data, size_t len, uint64_t seed);
+
+/**
+ * @brief Create a bounded LRU cache
+ * @param max_entries Maximum number of entries (must be non-zero)
+ * @param max_bytes Maximum input plus output bytes held, 0 for no byte bound
+ * @return New cache or NULL on error
+ */
+struct bej_cache* bej_cache_create(size_t max_entries, size_t max_bytes);
+
+/**
+ * @brief Free a cache and all of its entries
+ * @param cache Cache to free
+ */
+void bej_cache_free(struct bej_cache *cache);
+
+/**
+ * @brief Look up a previously rendered result
+ * @param cache Cache handle
+ * @param bej BEJ input bytes
+ * @param bej_len Length of BEJ input
+ * @param dict_id Identifier of the dictionary used for decoding
+ * @param profile Output profile (format and formatting options)
+ * @param out_len Output parameter for the rendered length (optional)
+ * @return Rendered output, valid until the next insert, or NULL on miss
+ */
+const char* bej_cache_lookup(struct bej_cache *cache, const unsigned char *bej, size_t bej_len,
+                             uint64_t dict_id, uint32_t profile, size_t *out_len);
+
+/**
+ * @brief Store a rendered result, evicting least recently used entries as needed
+ * @param cache Cache handle
+ * @param bej BEJ input bytes
+ * @param bej_len Length of BEJ input
+ * @param dict_id Identifier of the dictionary used for decoding
+ * @param profile Output profile (format and formatting options)
+ * @param out Rendered output
+ * @param out_len Length of rendered output
+ * @return 0 if stored, -1 if the entry does not fit or allocation failed
+ */
+int bej_cache_insert(struct bej_cache *cache, const unsigned char *bej, size_t bej_len,
+                     uint64_t dict_id, uint32_t profile, const char *out, size_t out_len);
+
+/**
+ * @brief Read cache counters
+ * @param cache Cache handle
+ * @param stats Output statistics
+ */
+void bej_cache_get_stats(const struct bej_cache *cache, struct bej_cache_stats *stats);
+
+#endif // BEJ_CACHE_H
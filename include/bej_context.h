@@ -0,0 +1,140 @@
+/**
+ * @file bej_context.h
+ * @brief Reusable decoder context for converting many BEJ documents without
+ *        per-document allocations
+ */
+
+#ifndef BEJ_CONTEXT_H
+#define BEJ_CONTEXT_H
+
+#include "bej_parser.h"
+#include "json_writer.h"
+#include <stddef.h>
+
+/** Default size of an arena block */
+#define BEJ_ARENA_BLOCK_SIZE  (64 * 1024)
+
+struct bej_arena_block;
+
+/** Bump allocator whose blocks are kept and reused after a reset */
+struct bej_arena {
+    struct bej_arena_block *head;     /**< First block */
+    struct bej_arena_block *current;  /**< Block currently being filled */
+    size_t block_size;                /**< Minimum size of a new block */
+    size_t blocks;                    /**< Number of blocks allocated so far */
+};
+
+/** Per-document limits enforced by a context; 0 disables a limit */
+struct bej_budget {
+    size_t max_nodes;            /**< Maximum number of decoded nodes */
+    size_t max_string;           /**< Maximum length of a single string value */
+    size_t max_output;           /**< Maximum size of the rendered output */
+};
+
+/** Outcome of decoding or converting one document through a context */
+enum bej_context_status {
+    BEJ_CONTEXT_OK = 0,          /**< Document converted completely */
+    BEJ_CONTEXT_TOO_DEEP,        /**< Containers were cut at the depth limit */
+    BEJ_CONTEXT_NODE_BUDGET,     /**< More nodes than budget.max_nodes */
+    BEJ_CONTEXT_STRING_BUDGET,   /**< A string longer than budget.max_string */
+    BEJ_CONTEXT_OUTPUT_BUDGET,   /**< Output larger than budget.max_output */
+    BEJ_CONTEXT_NO_MEMORY        /**< Arena could not grow */
+};
+
+/**
+ * Long-lived decoding state. Node storage, the output buffer, the explicit
+ * stack and the scratch buffer survive bej_context_reset(), so once they have
+ * grown to fit the largest document, converting more documents allocates
+ * nothing.
+ */
+struct bej_context {
+    struct bej_arena arena;      /**< Nodes, child arrays and values */
+    struct bej_stack stack;      /**< Decoder/writer stack */
+    struct dynamic_string out;   /**< Rendered output of the current document */
+    unsigned char *scratch;      /**< Caller scratch space, e.g. the input bytes */
+    size_t scratch_capacity;     /**< Size of the scratch buffer */
+    struct bej_budget budget;    /**< Per-document limits */
+    size_t nodes;                /**< Nodes decoded for the current document */
+    enum bej_context_status status; /**< First failure of the current document */
+};
+
+/**
+ * @brief Create a decoder context
+ * @param max_depth Maximum Set/Array nesting (the implicit root is added internally)
+ * @param budget Per-document limits, or NULL for none
+ * @return New context, or NULL on allocation failure
+ */
+struct bej_context* bej_context_create(size_t max_depth, const struct bej_budget *budget);
+
+/**
+ * @brief Free a context and everything it owns
+ * @param ctx Context to free
+ */
+void bej_context_free(struct bej_context *ctx);
+
+/**
+ * @brief Forget the previous document while keeping all storage
+ *
+ * Invalidates every node returned by bej_context_parse() and the contents
+ * of ctx->out.
+ *
+ * @param ctx Context to reset
+ */
+void bej_context_reset(struct bej_context *ctx);
+
+/**
+ * @brief Get a scratch buffer of at least size bytes
+ *
+ * The buffer is only grown, never shrunk, and is not touched by reset.
+ *
+ * @param ctx Context
+ * @param size Required size in bytes
+ * @return Scratch buffer, or NULL on allocation failure
+ */
+unsigned char* bej_context_scratch(struct bej_context *ctx, size_t size);
+
+/**
+ * @brief Allocate from an arena
+ * @param arena Arena
+ * @param size Number of bytes
+ * @return Memory aligned for any scalar type, or NULL on allocation failure
+ */
+void* bej_arena_alloc(struct bej_arena *arena, size_t size);
+
+/**
+ * @brief Decode a document into the context's arena
+ *
+ * The context is reset first. The tree stays valid until the next reset and
+ * must not be passed to free_bej_node(). Decoding stops at the first budget
+ * violation, which is recorded in ctx->status.
+ *
+ * @param ctx Context
+ * @param data BEJ binary data
+ * @param data_len Length of BEJ data in bytes
+ * @return Root node, or NULL if data is empty
+ */
+struct bej_node* bej_context_parse(struct bej_context *ctx, unsigned char *data, size_t data_len);
+
+/**
+ * @brief Decode a document and render it into ctx->out
+ * @param ctx Context
+ * @param data BEJ binary data
+ * @param data_len Length of BEJ data in bytes
+ * @param format Output format
+ * @param flags BEJ_OUTPUT_* flags
+ * @param map Field map for sequence to name conversion
+ * @param map_count Number of entries in field map
+ * @return BEJ_CONTEXT_OK, or the first failure; ctx->out is only complete on success
+ */
+enum bej_context_status bej_context_convert(struct bej_context *ctx, unsigned char *data, size_t data_len,
+                                            enum bej_output_format format, unsigned flags,
+                                            struct field_map *map, size_t map_count);
+
+/**
+ * @brief Describe a context status
+ * @param status Status code
+ * @return Static description string
+ */
+const char* bej_context_strerror(enum bej_context_status status);
+
+#endif // BEJ_CONTEXT_H
@@ -0,0 +1,61 @@
+/**
+ * @file bej_diff.h
+ * @brief Structural diff of two BEJ snapshots emitted as RFC 6902 JSON Patch
+ */
+
+#ifndef BEJ_DIFF_H
+#define BEJ_DIFF_H
+
+#include "bej_parser.h"
+#include "json_writer.h"
+#include <stddef.h>
+
+/**
+ * @brief Compare two BEJ encodings of the same resource and emit a JSON Patch
+ *
+ * Tuples whose encoded bytes are identical are skipped without decoding;
+ * only changed leaves (or whole values whose type changed) are decoded and
+ * rendered. When nothing changed the output is the empty patch "[]".
+ * Snapshots nested deeper than BEJ_DEFAULT_MAX_DEPTH are rejected.
+ *
+ * Paths are JSON Pointers into the converted JSON and so include the
+ * top-level member (/Sensor/Reading); bej_extractor_create() paths instead
+ * start inside a lone top-level Set (Reading).
+ *
+ * @param prev Previous BEJ snapshot
+ * @param prev_len Length of previous snapshot in bytes
+ * @param cur Current BEJ snapshot
+ * @param cur_len Length of current snapshot in bytes
+ * @param map Field map for sequence to name conversion
+ * @param map_count Number of entries in field map
+ * @param out Dynamic string receiving the JSON Patch document
+ * @return Number of patch operations, or -1 if either snapshot is malformed or too deep
+ */
+int bej_diff(unsigned char *prev, size_t prev_len,
+             unsigned char *cur, size_t cur_len,
+             struct field_map *map, size_t map_count,
+             struct dynamic_string *out);
+
+/**
+ * @brief Compare two BEJ snapshots using a caller-provided stack
+ *
+ * Same as bej_diff(), but the stack's maximum depth bounds both the diff walk
+ * and the rendering of added or replaced values.
+ *
+ * @param prev Previous BEJ snapshot
+ * @param prev_len Length of previous snapshot in bytes
+ * @param cur Current BEJ snapshot
+ * @param cur_len Length of current snapshot in bytes
+ * @param map Field map for sequence to name conversion
+ * @param map_count Number of entries in field map
+ * @param stack Explicit stack bounding the nesting depth
+ * @param out Dynamic string receiving the JSON Patch document
+ * @return Number of patch operations, or -1 if either snapshot is malformed
+ *         or nested deeper than the stack allows
+ */
+int bej_diff_stack(unsigned char *prev, size_t prev_len,
+                   unsigned char *cur, size_t cur_len,
+                   struct field_map *map, size_t map_count,
+                   struct bej_stack *stack, struct dynamic_string *out);
+
+#endif // BEJ_DIFF_H
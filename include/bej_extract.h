@@ -0,0 +1,115 @@
+/**
+ * @file bej_extract.h
+ * @brief Columnar extraction of selected fields from many BEJ payloads
+ */
+
+#ifndef BEJ_EXTRACT_H
+#define BEJ_EXTRACT_H
+
+#include "bej_parser.h"
+#include "json_writer.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/** Maximum number of columns per extractor */
+#define BEJ_EXTRACT_MAX_COLUMNS     64
+
+/** Maximum number of components in a field path */
+#define BEJ_EXTRACT_MAX_PATH_DEPTH  16
+
+/** Column value types; fixed by the first non-null value seen */
+enum bej_column_type {
+    BEJ_COLUMN_UNSET = 0,        /**< No value seen yet */
+    BEJ_COLUMN_INT,              /**< Integer values */
+    BEJ_COLUMN_ENUM,             /**< Enumeration option indices */
+    BEJ_COLUMN_BOOL,             /**< Boolean values stored as 0/1 */
+    BEJ_COLUMN_STRING            /**< String values */
+};
+
+/** One typed output column */
+struct bej_column {
+    char *path;                  /**< Field path as given, e.g. "Status/Health" */
+    uint64_t sequences[BEJ_EXTRACT_MAX_PATH_DEPTH]; /**< Sequence of each path component */
+    size_t depth;                /**< Number of path components */
+    enum bej_column_type type;   /**< Column type */
+    size_t capacity;             /**< Allocated rows */
+    int64_t *values;             /**< Integer, enum or boolean value per row */
+    uint8_t *valid;              /**< 1 if the row holds a value, 0 for missing/null */
+    uint32_t *str_offsets;       /**< String start per row plus end offset (rows + 1 entries) */
+    struct dynamic_string *str_data; /**< Concatenated string bytes */
+};
+
+/** Extraction state: the columns and the number of rows appended so far */
+struct bej_extractor {
+    struct bej_column *columns;  /**< Output columns */
+    size_t column_count;         /**< Number of columns */
+    size_t rows;                 /**< Rows (documents) extracted */
+};
+
+/**
+ * @brief Create an extractor for a list of field paths
+ *
+ * Paths are '/'-separated member names relative to the resource (the
+ * top-level Set), resolved to sequence numbers through the field map. When a
+ * document is one top-level Set its own name is not part of the path, unlike
+ * the JSON Pointers emitted by bej_diff().
+ *
+ * @param paths Field paths
+ * @param path_count Number of paths (at most BEJ_EXTRACT_MAX_COLUMNS)
+ * @param map Field map for name to sequence conversion
+ * @param map_count Number of entries in field map
+ * @return New extractor, or NULL if a path cannot be resolved
+ */
+struct bej_extractor* bej_extractor_create(const char **paths, size_t path_count,
+                                           struct field_map *map, size_t map_count);
+
+/**
+ * @brief Free an extractor and its columns
+ * @param ex Extractor to free
+ */
+void bej_extractor_free(struct bej_extractor *ex);
+
+/**
+ * @brief Scan one BEJ document and append one row to every column
+ *
+ * Only Sets on a requested path are entered; everything else is skipped by
+ * its length without being decoded.
+ *
+ * @param ex Extractor
+ * @param data BEJ binary data
+ * @param data_len Length of BEJ data in bytes
+ * @return 0 on success, -1 if the document is malformed (no row is appended)
+ */
+int bej_extract_document(struct bej_extractor *ex, unsigned char *data, size_t data_len);
+
+/**
+ * @brief Append a row in which every column is null
+ *
+ * Used in place of a document that could not be read or scanned, so row i
+ * still belongs to input i.
+ *
+ * @param ex Extractor
+ * @return 0 on success, -1 on allocation failure
+ */
+int bej_extract_null_row(struct bej_extractor *ex);
+
+/**
+ * @brief Render the columns as CSV with a header row of paths
+ * @param ex Extractor
+ * @param out Dynamic string receiving the CSV text
+ */
+void bej_extractor_write_csv(const struct bej_extractor *ex, struct dynamic_string *out);
+
+/**
+ * @brief Render the columns in a simple little-endian binary columnar layout
+ *
+ * "BEJCOL01", u32 column count, u64 row count, then per column: u16 path
+ * length, path bytes, u8 type, one validity byte per row, and either one
+ * int64 per row or (rows + 1) u32 string offsets followed by the string bytes.
+ *
+ * @param ex Extractor
+ * @param out Dynamic string receiving the encoded columns
+ */
+void bej_extractor_write_binary(const struct bej_extractor *ex, struct dynamic_string *out);
+
+#endif // BEJ_EXTRACT_H
@@ -0,0 +1,74 @@
+/**
+ * @file bej_ingest.h
+ * @brief Read-ahead file ingestion for batch conversion
+ */
+
+#ifndef BEJ_INGEST_H
+#define BEJ_INGEST_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/** Default number of files read ahead of the decoder */
+#define BEJ_INGEST_DEFAULT_DEPTH    8
+
+/** Default number of reader threads for the thread pool backend */
+#define BEJ_INGEST_DEFAULT_THREADS  4
+
+/** Opaque ingestion pipeline */
+struct bej_ingest;
+
+/** One file handed to the consumer, in the order the paths were given */
+struct bej_ingest_buffer {
+    const char *path;            /**< File path */
+    size_t index;                /**< Position in the path list */
+    unsigned char *data;         /**< File contents, valid until released */
+    size_t size;                 /**< File size in bytes */
+    int error;                   /**< errno of a failed open/read, 0 on success */
+};
+
+/**
+ * @brief Start reading files ahead of the consumer
+ *
+ * Up to depth files are read concurrently into buffers that are reused for
+ * later files. Built with liburing, one thread keeps the reads in flight on an
+ * io_uring; otherwise (or if the ring cannot be set up) a pool of threads
+ * uses blocking reads.
+ *
+ * @param paths Files to read; the array must outlive the pipeline
+ * @param count Number of files
+ * @param depth Maximum files read but not yet released (0 for the default)
+ * @param threads Reader threads for the thread pool backend (0 for the default)
+ * @return New pipeline, or NULL on error
+ */
+struct bej_ingest* bej_ingest_open(char **paths, size_t count, size_t depth, size_t threads);
+
+/**
+ * @brief Wait for the next file in path order
+ * @param in Pipeline
+ * @param buf Output buffer description
+ * @return false once every file has been delivered
+ */
+bool bej_ingest_next(struct bej_ingest *in, struct bej_ingest_buffer *buf);
+
+/**
+ * @brief Hand a delivered buffer back so its slot can read another file
+ * @param in Pipeline
+ * @param buf Buffer returned by the last bej_ingest_next()
+ */
+void bej_ingest_release(struct bej_ingest *in, struct bej_ingest_buffer *buf);
+
+/**
+ * @brief Stop reading, join the readers and free all buffers
+ * @param in Pipeline
+ */
+void bej_ingest_close(struct bej_ingest *in);
+
+/**
+ * @brief Name of the backend in use
+ * @param in Pipeline
+ * @return "io_uring" or "threads"
+ */
+const char* bej_ingest_backend(const struct bej_ingest *in);
+
+#endif // BEJ_INGEST_H
@@ -22,6 +22,9 @@
 #define BEJ_FORMAT_PROPERTY  0x08    /**< Property type */
 #define BEJ_FORMAT_NULL      0x00    /**< Null type */
 
+/** Default maximum Set/Array nesting for the decoder and the writer */
+#define BEJ_DEFAULT_MAX_DEPTH 64
+
 /** BEJ node structure representing parsed data element */
 struct bej_node {
     uint8_t format;              /**< BEJ format type (bits 0-3) */
@@ -34,10 +37,36 @@ struct bej_node {
     uint8_t dictionary_type;     /**< Dictionary type (0=main, 1=annotation) */
 };
 
+/** Decoded SFLV tuple header (sequence, format and length) */
+struct bej_sflv_header {
+    uint64_t sequence;           /**< Dictionary sequence number */
+    uint8_t dictionary_type;     /**< Dictionary type (0=main, 1=annotation) */
+    uint8_t format;              /**< BEJ format type (bits 0-3) */
+    uint8_t format_flags;        /**< Format flags (bits 4-7) */
+    size_t length;               /**< Value length in bytes */
+};
+
+/** Frame of the explicit stack used instead of recursion */
+struct bej_frame {
+    struct bej_node *node;       /**< Open Set or Array */
+    unsigned char *end;          /**< End of the container value (decoder) */
+    size_t index;                /**< Next child to emit (writer) */
+};
+
+/** Preallocated explicit stack shared by the decoder and the JSON writer */
+struct bej_stack {
+    struct bej_frame *frames;    /**< Frame storage, max_depth entries */
+    size_t max_depth;            /**< Maximum Set/Array nesting */
+};
+
+struct bej_context;
+
 /** Field mapping structure for sequence number to name mapping */
 struct field_map {
     uint64_t sequence;           /**< Field sequence number */
-    char *name;                  /**< Field name string */
+    char *name;                  /**< Field name string (interned by load_map(); heap-allocated in hand-built maps) */
+    char *key;                   /**< Escaped JSON key token `"name": ` (NULL if not built) */
+    size_t key_len;              /**< Length of key; key_len - 1 drops the trailing space */
 };
 
 /**
@@ -50,11 +79,50 @@ struct field_map* load_map(const char *map_path, size_t *count);
 
 /**
  * @brief Free memory allocated for field map
+ *
+ * Frees every name and key token that is not in the shared string pool,
+ * then the array. Maps from load_map() keep their interned strings in the
+ * pool (see bej_strpool.h); hand-built maps hand over heap-allocated names
+ * and build_field_key() tokens exactly as before the pool existed.
+ *
  * @param map Field map array to free
  * @param count Number of entries in the map
  */
 void free_map(struct field_map *map, size_t count);
 
+/**
+ * @brief Build the escaped JSON key token of a map entry from its name
+ *
+ * load_map() does this for every entry; maps assembled by hand may call it
+ * so the JSON writer can emit their keys with a single copy.
+ *
+ * @param entry Map entry with a name; any previous token is replaced
+ * @return false on allocation failure (the token is heap-allocated and freed by free_map())
+ */
+bool build_field_key(struct field_map *entry);
+
+/**
+ * @brief Escape bytes for use inside a JSON string literal
+ *
+ * '"' and '\\' get a backslash and control characters become \u00XX; all
+ * other bytes are copied unchanged.
+ *
+ * @param dst Output buffer of at least len * 6 bytes (not NUL-terminated)
+ * @param src Bytes to escape
+ * @param len Number of bytes
+ * @return Number of bytes written to dst
+ */
+size_t bej_json_escape(char *dst, const char *src, size_t len);
+
+/**
+ * @brief Get map entry by sequence number
+ * @param seq Sequence number to look up
+ * @param map Field map array
+ * @param count Number of entries in the map
+ * @return Map entry or NULL if not found
+ */
+const struct field_map* get_field_entry(uint64_t seq, const struct field_map *map, size_t count);
+
 /**
  * @brief Get field name by sequence number
  * @param seq Sequence number to look up
@@ -64,6 +132,20 @@ void free_map(struct field_map *map, size_t count);
  */
 const char* get_field_name(uint64_t seq, struct field_map *map, size_t count);
 
+/**
+ * @brief Allocate an explicit stack
+ * @param stack Stack to initialize
+ * @param max_depth Maximum Set/Array nesting
+ * @return true on success
+ */
+bool bej_stack_init(struct bej_stack *stack, size_t max_depth);
+
+/**
+ * @brief Free memory allocated for an explicit stack
+ * @param stack Stack to free
+ */
+void bej_stack_free(struct bej_stack *stack);
+
 /**
  * @brief Initialize BEJ parsing from binary data
  * @param bej Pointer to BEJ binary data
@@ -74,7 +156,56 @@ const char* get_field_name(uint64_t seq, struct field_map *map, size_t count);
 struct bej_node* parse_sflv_init(unsigned char *bej, size_t bej_len, unsigned char *schema_dict);
 
 /**
- * @brief Recursive BEJ parsing function
+ * @brief Parse BEJ binary data using a caller-provided stack
+ *
+ * Containers nested deeper than the stack's maximum depth are skipped and
+ * decoded as BEJ_FORMAT_NULL nodes, which the writers emit as null.
+ *
+ * @param bej Pointer to BEJ binary data
+ * @param bej_len Length of BEJ data in bytes
+ * @param stack Explicit stack bounding the nesting depth (max_depth must be at least 1)
+ * @return Root BEJ node or NULL on error
+ */
+struct bej_node* parse_sflv_init_stack(unsigned char *bej, size_t bej_len, struct bej_stack *stack);
+
+/**
+ * @brief Parse BEJ binary data into a context's arena
+ *
+ * Uses the context's stack and budgets; see bej_context_parse(), which also
+ * resets the context first.
+ *
+ * @param bej Pointer to BEJ binary data
+ * @param bej_len Length of BEJ data in bytes
+ * @param ctx Decoder context receiving the nodes
+ * @return Root BEJ node (owned by the context) or NULL on error
+ */
+struct bej_node* parse_sflv_init_context(unsigned char *bej, size_t bej_len, struct bej_context *ctx);
+
+/**
+ * @brief Parse one SFLV tuple and its members without recursion
+ * @param node Node receiving the tuple
+ * @param data Pointer to current position in data buffer
+ * @param data_end Pointer to end of data buffer
+ * @param stack Explicit stack bounding the nesting depth; with max_depth 0 a
+ *              Set or Array tuple is skipped as a whole
+ * @return 0 on success, -1 if containers were skipped (decoded as null) for exceeding the depth limit
+ */
+int parse_sflv_stack(struct bej_node *node, unsigned char **data, unsigned char *data_end, struct bej_stack *stack);
+
+/**
+ * @brief Read the S, F and L parts of an SFLV tuple
+ * @param data Pointer to current position in data buffer, advanced past the header
+ * @param data_end Pointer to end of data buffer
+ * @param hdr Output header
+ * @return true if the whole header was read, false if it is truncated or malformed
+ */
+bool read_sflv_header(unsigned char **data, unsigned char *data_end, struct bej_sflv_header *hdr);
+
+/**
+ * @brief Parse one SFLV tuple with the default maximum depth
+ *
+ * Kept for compatibility; decoding is iterative (see parse_sflv_stack()).
+ *
  * @param node Current node being parsed
  * @param data Pointer to current position in data buffer
  * @param data_end Pointer to end of data buffer
@@ -89,10 +220,22 @@ void parse_sflv_recursion(struct bej_node *node, unsigned char **data, unsigned
  */
 void free_bej_node(struct bej_node *node);
 
+/**
+ * @brief Read a DSP0218 nnint: a byte count N (0-8) followed by N little-endian bytes
+ * @param data Pointer to current position in data buffer, advanced on success
+ * @param data_end Pointer to end of data buffer
+ * @param out Decoded value
+ * @return false if the nnint is truncated or wider than 64 bits
+ */
+bool read_nnint(unsigned char **data, unsigned char *data_end, uint64_t *out);
+
 /** Basic data reading functions */
-uint64_t read_uint64(unsigned char **data, int length, unsigned char *data_end);
-int read_int(unsigned char **data, int length, unsigned char *data_end);
-char* read_str(unsigned char **data, int length, unsigned char *data_end);
+/** Reads length little-endian bytes (only the low 8 contribute to the value) */
+uint64_t read_uint64(unsigned char **data, size_t length, unsigned char *data_end);
+int read_int(unsigned char **data, size_t length, unsigned char *data_end);
+/** Copies length bytes into a new NUL-terminated string; NULL if they run past data_end */
+char* read_str(unsigned char **data, size_t length, unsigned char *data_end);
+/** Reads a LEB128 varint (not used for SFLV headers, which are nnint encoded) */
 uint64_t read_varint_u64(unsigned char **data, unsigned char *data_end);
 
 #endif // BEJ_PARSER_H
\ No newline at end of file
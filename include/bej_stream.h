@@ -0,0 +1,92 @@
+/**
+ * @file bej_stream.h
+ * @brief Reader for files and pipes holding many BEJ records back to back
+ */
+
+#ifndef BEJ_STREAM_H
+#define BEJ_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/** Default largest record accepted from a stream */
+#define BEJ_STREAM_DEFAULT_MAX_RECORD  (64u * 1024 * 1024)
+
+/** Ceiling for any record limit, including "no limit" (0) */
+#define BEJ_STREAM_MAX_RECORD_CAP      (1024u * 1024 * 1024)
+
+/** How records are delimited in a stream */
+enum bej_stream_framing {
+    BEJ_FRAMING_CONCAT = 0,      /**< Each record is one top-level SFLV tuple, no extra framing */
+    BEJ_FRAMING_LENGTH,          /**< u32 little-endian record length, then the record */
+    BEJ_FRAMING_LENGTH_SCHEMA    /**< u32 record length, u32 schema id (both LE), then the record */
+};
+
+/** Result of reading one record */
+enum bej_stream_status {
+    BEJ_STREAM_RECORD = 0,       /**< A record was read */
+    BEJ_STREAM_END,              /**< Clean end of input at a record boundary */
+    BEJ_STREAM_TOO_LARGE,        /**< Record over the size limit; it was skipped */
+    BEJ_STREAM_TRUNCATED,        /**< Input ended inside a record */
+    BEJ_STREAM_BAD_HEADER,       /**< Unreadable tuple header (concatenated framing) */
+    BEJ_STREAM_NO_MEMORY         /**< Record buffer could not grow */
+};
+
+/** Stream state; the record buffer is reused for every record */
+struct bej_stream {
+    FILE *file;                  /**< Input, e.g. stdin */
+    enum bej_stream_framing framing; /**< Record delimiting */
+    size_t max_record;           /**< Largest accepted record in bytes */
+    unsigned char *buf;          /**< Record buffer */
+    size_t capacity;             /**< Allocated bytes */
+    uint64_t offset;             /**< Bytes consumed so far */
+    uint64_t records;            /**< Records returned so far */
+};
+
+/** One record; data is valid until the next bej_stream_next() */
+struct bej_stream_record {
+    unsigned char *data;         /**< BEJ bytes */
+    size_t size;                 /**< Number of BEJ bytes */
+    uint32_t schema_id;          /**< Schema id (BEJ_FRAMING_LENGTH_SCHEMA only) */
+    bool has_schema;             /**< schema_id was present in the framing */
+    uint64_t offset;             /**< Stream offset of the record's framing */
+};
+
+/**
+ * @brief Prepare a stream reader
+ * @param s Stream state
+ * @param file Input file, read sequentially (pipes work)
+ * @param framing Record delimiting
+ * @param max_record Largest accepted record in bytes; 0 or anything above
+ *                   BEJ_STREAM_MAX_RECORD_CAP means BEJ_STREAM_MAX_RECORD_CAP
+ */
+void bej_stream_init(struct bej_stream *s, FILE *file, enum bej_stream_framing framing, size_t max_record);
+
+/**
+ * @brief Read the next record
+ *
+ * After BEJ_STREAM_TOO_LARGE the stream is positioned at the next record and
+ * reading may continue; other errors end the stream.
+ *
+ * @param s Stream state
+ * @param rec Output record
+ * @return Status of the read
+ */
+enum bej_stream_status bej_stream_next(struct bej_stream *s, struct bej_stream_record *rec);
+
+/**
+ * @brief Free the record buffer
+ * @param s Stream state (the file is not closed)
+ */
+void bej_stream_free(struct bej_stream *s);
+
+/**
+ * @brief Describe a stream status
+ * @param status Status code
+ * @return Static description string
+ */
+const char* bej_stream_strerror(enum bej_stream_status status);
+
+#endif // BEJ_STREAM_H
@@ -0,0 +1,60 @@
+/**
+ * @file bej_strpool.h
+ * @brief Process-wide pool of interned, deduplicated strings
+ */
+
+#ifndef BEJ_STRPOOL_H
+#define BEJ_STRPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Pool counters */
+struct bej_strpool_stats {
+    size_t strings;      /**< Distinct strings stored */
+    size_t bytes;        /**< Bytes of string data stored, terminators included */
+    uint64_t lookups;    /**< bej_intern() calls */
+    uint64_t hits;       /**< Calls answered with an already stored string */
+};
+
+/**
+ * @brief Intern a string
+ *
+ * Every call with the same bytes returns the same pointer, so dictionaries
+ * loaded side by side share one copy of each name and key token. Interned
+ * strings are immutable and live until bej_strpool_clear(). Thread-safe.
+ *
+ * @param s String bytes (need not be NUL-terminated)
+ * @param len Number of bytes
+ * @return Pooled NUL-terminated copy, or NULL on allocation failure
+ */
+const char* bej_intern(const char *s, size_t len);
+
+/**
+ * @brief Tell whether a string was returned by bej_intern()
+ *
+ * Lets free_map() release the names of hand-built maps while leaving
+ * pooled ones alone. Walks the storage chunks, so it is meant for teardown
+ * rather than hot paths.
+ *
+ * @param s String to check
+ * @return true if s points into the pool's storage
+ */
+bool bej_strpool_owns(const char *s);
+
+/**
+ * @brief Read the pool counters
+ * @param stats Output counters
+ */
+void bej_strpool_get_stats(struct bej_strpool_stats *stats);
+
+/**
+ * @brief Release every interned string
+ *
+ * Only safe once nothing refers to the pool any more, i.e. after every map
+ * returned by load_map() has been freed.
+ */
+void bej_strpool_clear(void);
+
+#endif // BEJ_STRPOOL_H
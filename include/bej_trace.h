@@ -0,0 +1,35 @@
+/**
+ * @file bej_trace.h
+ * @brief Static (USDT/SDT) tracepoints for perf, bpftrace and SystemTap
+ *
+ * Built with BEJ_HAVE_SDT (set by CMake when <sys/sdt.h> is found), each
+ * macro places a "bej" provider probe: a single nop plus a note section entry
+ * that costs nothing until a tracer attaches. Without it the macros expand to
+ * nothing.
+ *
+ * Probes:
+ * - document_start(data, length)
+ * - document_end(length, rc)
+ * - container_enter(format, sequence, length, depth)
+ * - container_exit(sequence, depth)
+ * - dict_miss(sequence)
+ * - writer_flush(format, length, rc)
+ */
+
+#ifndef BEJ_TRACE_H
+#define BEJ_TRACE_H
+
+#ifdef BEJ_HAVE_SDT
+#include <sys/sdt.h>
+#define BEJ_TRACE1(name, a)             DTRACE_PROBE1(bej, name, a)
+#define BEJ_TRACE2(name, a, b)          DTRACE_PROBE2(bej, name, a, b)
+#define BEJ_TRACE3(name, a, b, c)       DTRACE_PROBE3(bej, name, a, b, c)
+#define BEJ_TRACE4(name, a, b, c, d)    DTRACE_PROBE4(bej, name, a, b, c, d)
+#else
+#define BEJ_TRACE1(name, a)             do { } while (0)
+#define BEJ_TRACE2(name, a, b)          do { } while (0)
+#define BEJ_TRACE3(name, a, b, c)       do { } while (0)
+#define BEJ_TRACE4(name, a, b, c, d)    do { } while (0)
+#endif
+
+#endif // BEJ_TRACE_H
@@ -0,0 +1,68 @@
+/**
+ * @file bej_validate.h
+ * @brief Allocation-free structural validation of BEJ payloads
+ */
+
+#ifndef BEJ_VALIDATE_H
+#define BEJ_VALIDATE_H
+
+#include "bej_parser.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/** Hard upper bound for the validator's nesting stack */
+#define BEJ_VALIDATE_MAX_DEPTH 256
+
+/** Validation result codes */
+enum bej_validate_status {
+    BEJ_VALID = 0,              /**< Payload is structurally valid */
+    BEJ_ERR_TRUNCATED_HEADER,   /**< SFLV header runs past its parent or the buffer */
+    BEJ_ERR_LENGTH_OVERRUN,     /**< Value length runs past its parent or the buffer */
+    BEJ_ERR_BAD_FORMAT,         /**< Unknown format code */
+    BEJ_ERR_BAD_LENGTH,         /**< Length not allowed for the format */
+    BEJ_ERR_TOO_DEEP,           /**< Nesting deeper than the configured limit */
+    BEJ_ERR_BAD_SEQUENCE,       /**< Sequence number outside the dictionary */
+    BEJ_ERR_EMPTY               /**< No data */
+};
+
+/** Validation limits */
+struct bej_validate_limits {
+    size_t max_depth;            /**< Maximum Set/Array nesting, 0 for BEJ_VALIDATE_MAX_DEPTH */
+    uint64_t max_sequence;       /**< Highest main dictionary sequence, UINT64_MAX to skip the check */
+};
+
+/** Validation error details */
+struct bej_validate_error {
+    enum bej_validate_status status;  /**< Result code */
+    size_t offset;                    /**< Offset of the offending tuple */
+    size_t depth;                     /**< Nesting depth of the offending tuple */
+};
+
+/**
+ * @brief Check every SFLV tuple without decoding values or allocating memory
+ * @param data BEJ binary data
+ * @param data_len Length of BEJ data in bytes
+ * @param limits Validation limits (optional, defaults when NULL)
+ * @param err Error details (optional)
+ * @return BEJ_VALID or the first error found
+ */
+enum bej_validate_status bej_validate(unsigned char *data, size_t data_len,
+                                      const struct bej_validate_limits *limits,
+                                      struct bej_validate_error *err);
+
+/**
+ * @brief Highest main dictionary sequence number in a field map
+ * @param map Field map array
+ * @param count Number of entries in the map
+ * @return Highest sequence, or UINT64_MAX for an empty map
+ */
+uint64_t bej_map_max_sequence(struct field_map *map, size_t count);
+
+/**
+ * @brief Human readable description of a validation result
+ * @param status Validation result code
+ * @return Static string
+ */
+const char* bej_validate_strerror(enum bej_validate_status status);
+
+#endif // BEJ_VALIDATE_H
@@ -0,0 +1,33 @@
+/**
+ * @file binary_writer.h
+ * @brief CBOR and MessagePack writers for BEJ node trees
+ */
+
+#ifndef BINARY_WRITER_H
+#define BINARY_WRITER_H
+
+#include "bej_parser.h"
+#include "json_writer.h"
+#include <stddef.h>
+
+/**
+ * @brief Transcode a BEJ node tree straight to CBOR or MessagePack
+ *
+ * Sets become maps keyed by dictionary names (or by sequence numbers with
+ * BEJ_OUTPUT_INT_KEYS), Arrays become arrays. No JSON text is produced.
+ *
+ * @param node BEJ node to convert
+ * @param out Dynamic string receiving the encoded bytes
+ * @param format BEJ_OUTPUT_CBOR or BEJ_OUTPUT_MSGPACK
+ * @param flags BEJ_OUTPUT_* flags
+ * @param map Field map for sequence to name conversion
+ * @param map_count Number of entries in field map
+ * @param stack Explicit stack bounding the nesting depth
+ * @return 0 on success, -1 if containers were cut at the depth limit
+ */
+int bej_node_to_binary_stack(struct bej_node *node, struct dynamic_string *out,
+                             enum bej_output_format format, unsigned flags,
+                             struct field_map *map, size_t map_count,
+                             struct bej_stack *stack);
+
+#endif // BINARY_WRITER_H
@@ -17,8 +17,23 @@ struct dynamic_string {
     char *data;        /**< String data buffer */
     size_t length;     /**< Current string length */
     size_t capacity;   /**< Buffer capacity */
+    size_t limit;      /**< Maximum length, 0 for unlimited */
+    bool overflow;     /**< An append was dropped for exceeding limit */
 };
 
+/** Output formats selectable through bej_write_node() */
+enum bej_output_format {
+    BEJ_OUTPUT_JSON = 0,     /**< Pretty-printed JSON text */
+    BEJ_OUTPUT_CBOR,         /**< CBOR (RFC 8949) */
+    BEJ_OUTPUT_MSGPACK       /**< MessagePack */
+};
+
+/** bej_write_node() flag: binary formats use sequence numbers as Set keys */
+#define BEJ_OUTPUT_INT_KEYS  0x01
+
+/** bej_write_node() flag: JSON on a single line without indentation */
+#define BEJ_OUTPUT_COMPACT   0x02
+
 /** Map entry structure (unused in current implementation) */
 struct map_entry {
     char *name;                    /**< Entry name */
@@ -39,6 +54,18 @@ struct dynamic_string* dynamic_string_init();
  */
 void dynamic_string_append(struct dynamic_string *str, const char *s);
 
+/**
+ * @brief Append raw bytes to dynamic string
+ *
+ * An append that would take the string past its limit is dropped and sets
+ * the overflow flag.
+ *
+ * @param str Dynamic string to append to
+ * @param s Bytes to append (may contain NUL)
+ * @param len Number of bytes
+ */
+void dynamic_string_append_len(struct dynamic_string *str, const void *s, size_t len);
+
 /**
  * @brief Add indentation tabs to string
  * @param str Dynamic string
@@ -47,7 +74,10 @@ void dynamic_string_append(struct dynamic_string *str, const char *s);
 void add_tab(struct dynamic_string *str, int tab);
 
 /**
- * @brief Convert BEJ node to JSON string recursively
+ * @brief Convert BEJ node to JSON string with the default maximum depth
+ *
+ * Kept for compatibility; writing is iterative (see bej_node_to_str_stack()).
+ *
  * @param node BEJ node to convert
  * @param str Dynamic string for JSON output
  * @param key Field key name (NULL for arrays)
@@ -59,6 +89,41 @@ void parse_bej_node_to_str_recursion(struct bej_node *node, struct dynamic_strin
                                      const char *key, int indent,
                                      struct field_map *map, size_t map_count);
 
+/**
+ * @brief Convert BEJ node to JSON string using a caller-provided stack
+ *
+ * Containers nested deeper than the stack's maximum depth are written as null.
+ *
+ * @param node BEJ node to convert
+ * @param str Dynamic string for JSON output
+ * @param key Field key name (NULL for arrays)
+ * @param indent Indentation level
+ * @param map Field map for sequence to name conversion
+ * @param map_count Number of entries in field map
+ * @param stack Explicit stack bounding the nesting depth
+ * @return 0 on success, -1 if containers were cut at the depth limit
+ */
+int bej_node_to_str_stack(struct bej_node *node, struct dynamic_string *str,
+                          const char *key, int indent,
+                          struct field_map *map, size_t map_count,
+                          struct bej_stack *stack);
+
+/**
+ * @brief Write a BEJ node tree in the requested output format
+ * @param node BEJ node to convert
+ * @param out Dynamic string receiving the output (binary formats may contain NUL)
+ * @param format Output format
+ * @param flags BEJ_OUTPUT_* flags
+ * @param map Field map for sequence to name conversion
+ * @param map_count Number of entries in field map
+ * @param stack Explicit stack bounding the nesting depth
+ * @return 0 on success, -1 if containers were cut at the depth limit
+ */
+int bej_write_node(struct bej_node *node, struct dynamic_string *out,
+                   enum bej_output_format format, unsigned flags,
+                   struct field_map *map, size_t map_count,
+                   struct bej_stack *stack);
+
 // Note: parse_map_file and free_map_entry are not implemented
 struct map_entry* parse_map_file(const char *filename);
 void free_map_entry(struct map_entry *map);
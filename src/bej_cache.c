@@ -0,0 +1,252 @@
+/**
+ * @file bej_cache.c
+ * @brief Content-addressed LRU cache implementation
+ */
+
+#include "bej_cache.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+/** Cached conversion; input and output bytes follow the struct */
+struct cache_entry {
+    uint64_t hash;                 /**< Hash of input, dictionary and profile */
+    uint64_t dict_id;              /**< Dictionary identifier */
+    uint32_t profile;              /**< Output profile */
+    size_t bej_len;                /**< Input length */
+    size_t out_len;                /**< Rendered output length */
+    struct cache_entry *chain;     /**< Next entry in the same bucket */
+    struct cache_entry *prev;      /**< More recently used neighbour */
+    struct cache_entry *next;      /**< Less recently used neighbour */
+    unsigned char data[];          /**< Input bytes, then NUL-terminated output */
+};
+
+struct bej_cache {
+    struct cache_entry **buckets;  /**< Hash buckets */
+    size_t bucket_mask;            /**< Bucket count minus one */
+    struct cache_entry *head;      /**< Most recently used entry */
+    struct cache_entry *tail;      /**< Least recently used entry */
+    size_t max_entries;            /**< Entry bound */
+    size_t max_bytes;              /**< Byte bound, 0 for none */
+    struct bej_cache_stats stats;  /**< Counters */
+};
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t load64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t load32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hash_round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline uint64_t hash_merge(uint64_t acc, uint64_t val) {
+    acc ^= hash_round(0, val);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t bej_hash64(const void *data, size_t len, uint64_t seed) {
+    const unsigned char *p = data;
+    const unsigned char *end = p + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        const unsigned char *limit = end - 32;
+        do {
+            v1 = hash_round(v1, load64(p));
+            v2 = hash_round(v2, load64(p + 8));
+            v3 = hash_round(v3, load64(p + 16));
+            v4 = hash_round(v4, load64(p + 24));
+            p += 32;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = hash_merge(h, v1);
+        h = hash_merge(h, v2);
+        h = hash_merge(h, v3);
+        h = hash_merge(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+
+    h += (uint64_t)len;
+
+    while (p + 8 <= end) {
+        h ^= hash_round(0, load64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)load32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+        p++;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+static uint64_t cache_key_hash(const unsigned char *bej, size_t bej_len, uint64_t dict_id, uint32_t profile) {
+    return bej_hash64(bej, bej_len, dict_id ^ ((uint64_t)profile * PRIME64_3));
+}
+
+struct bej_cache* bej_cache_create(size_t max_entries, size_t max_bytes) {
+    if (max_entries == 0) return NULL;
+
+    struct bej_cache *cache = calloc(1, sizeof(struct bej_cache));
+    if (!cache) return NULL;
+
+    size_t buckets = 16;
+    while (buckets < max_entries) buckets *= 2;
+    cache->buckets = calloc(buckets, sizeof(struct cache_entry*));
+    if (!cache->buckets) { free(cache); return NULL; }
+
+    cache->bucket_mask = buckets - 1;
+    cache->max_entries = max_entries;
+    cache->max_bytes = max_bytes;
+    return cache;
+}
+
+void bej_cache_free(struct bej_cache *cache) {
+    if (!cache) return;
+    struct cache_entry *e = cache->head;
+    while (e) {
+        struct cache_entry *next = e->next;
+        free(e);
+        e = next;
+    }
+    free(cache->buckets);
+    free(cache);
+}
+
+static void lru_unlink(struct bej_cache *cache, struct cache_entry *e) {
+    if (e->prev) e->prev->next = e->next; else cache->head = e->next;
+    if (e->next) e->next->prev = e->prev; else cache->tail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void lru_push_front(struct bej_cache *cache, struct cache_entry *e) {
+    e->prev = NULL;
+    e->next = cache->head;
+    if (cache->head) cache->head->prev = e;
+    cache->head = e;
+    if (!cache->tail) cache->tail = e;
+}
+
+static void evict_tail(struct bej_cache *cache) {
+    struct cache_entry *victim = cache->tail;
+    if (!victim) return;
+
+    struct cache_entry **link = &cache->buckets[victim->hash & cache->bucket_mask];
+    while (*link && *link != victim) link = &(*link)->chain;
+    if (*link) *link = victim->chain;
+
+    lru_unlink(cache, victim);
+    cache->stats.entries--;
+    cache->stats.bytes -= victim->bej_len + victim->out_len;
+    cache->stats.evictions++;
+    free(victim);
+}
+
+static struct cache_entry* find_entry(struct bej_cache *cache, uint64_t hash, const unsigned char *bej,
+                                      size_t bej_len, uint64_t dict_id, uint32_t profile) {
+    struct cache_entry *e = cache->buckets[hash & cache->bucket_mask];
+    for (; e; e = e->chain) {
+        // Full input comparison rules out hash collisions; it is still far cheaper than decoding
+        if (e->hash == hash && e->bej_len == bej_len && e->dict_id == dict_id &&
+            e->profile == profile && memcmp(e->data, bej, bej_len) == 0)
+            return e;
+    }
+    return NULL;
+}
+
+const char* bej_cache_lookup(struct bej_cache *cache, const unsigned char *bej, size_t bej_len,
+                             uint64_t dict_id, uint32_t profile, size_t *out_len) {
+    if (!cache || !bej) return NULL;
+
+    uint64_t hash = cache_key_hash(bej, bej_len, dict_id, profile);
+    struct cache_entry *e = find_entry(cache, hash, bej, bej_len, dict_id, profile);
+    if (!e) {
+        cache->stats.misses++;
+        return NULL;
+    }
+
+    cache->stats.hits++;
+    if (cache->head != e) {
+        lru_unlink(cache, e);
+        lru_push_front(cache, e);
+    }
+    if (out_len) *out_len = e->out_len;
+    return (const char*)(e->data + e->bej_len);
+}
+
+int bej_cache_insert(struct bej_cache *cache, const unsigned char *bej, size_t bej_len,
+                     uint64_t dict_id, uint32_t profile, const char *out, size_t out_len) {
+    if (!cache || !bej || !out) return -1;
+
+    size_t bytes = bej_len + out_len;
+    if (cache->max_bytes && bytes > cache->max_bytes) return -1;
+
+    uint64_t hash = cache_key_hash(bej, bej_len, dict_id, profile);
+    if (find_entry(cache, hash, bej, bej_len, dict_id, profile)) return 0;
+
+    while (cache->stats.entries >= cache->max_entries ||
+           (cache->max_bytes && cache->stats.bytes + bytes > cache->max_bytes))
+        evict_tail(cache);
+
+    struct cache_entry *e = malloc(sizeof(struct cache_entry) + bytes + 1);
+    if (!e) { perror("malloc"); return -1; }
+    e->hash = hash;
+    e->dict_id = dict_id;
+    e->profile = profile;
+    e->bej_len = bej_len;
+    e->out_len = out_len;
+    memcpy(e->data, bej, bej_len);
+    memcpy(e->data + bej_len, out, out_len);
+    e->data[bytes] = '\0';
+
+    size_t bucket = hash & cache->bucket_mask;
+    e->chain = cache->buckets[bucket];
+    cache->buckets[bucket] = e;
+    lru_push_front(cache, e);
+
+    cache->stats.entries++;
+    cache->stats.bytes += bytes;
+    return 0;
+}
+
+void bej_cache_get_stats(const struct bej_cache *cache, struct bej_cache_stats *stats) {
+    if (!cache || !stats) return;
+    *stats = cache->stats;
+}
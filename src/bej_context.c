@@ -0,0 +1,150 @@
+/**
+ * @file bej_context.c
+ * @brief Reusable decoder context implementation
+ */
+
+#include "bej_context.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdalign.h>
+
+/** Arena block header; the usable bytes follow it */
+struct bej_arena_block {
+    struct bej_arena_block *next;  /**< Next block in allocation order */
+    size_t size;                   /**< Usable bytes */
+    size_t used;                   /**< Bytes handed out since the last reset */
+    alignas(max_align_t) unsigned char data[]; /**< Block storage */
+};
+
+void* bej_arena_alloc(struct bej_arena *arena, size_t size) {
+    size = (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+
+    // Walk forward through blocks kept from earlier documents before growing
+    struct bej_arena_block *block = arena->current;
+    while (block && block->size - block->used < size) block = block->next;
+
+    if (!block) {
+        size_t block_size = size > arena->block_size ? size : arena->block_size;
+        block = malloc(sizeof(struct bej_arena_block) + block_size);
+        if (!block) return NULL;
+        block->next = NULL;
+        block->size = block_size;
+        block->used = 0;
+        arena->blocks++;
+
+        if (!arena->head) {
+            arena->head = block;
+        } else {
+            struct bej_arena_block *tail = arena->current ? arena->current : arena->head;
+            while (tail->next) tail = tail->next;
+            tail->next = block;
+        }
+    }
+
+    arena->current = block;
+    void *p = block->data + block->used;
+    block->used += size;
+    return p;
+}
+
+static void arena_reset(struct bej_arena *arena) {
+    for (struct bej_arena_block *b = arena->head; b; b = b->next) b->used = 0;
+    arena->current = arena->head;
+}
+
+static void arena_free(struct bej_arena *arena) {
+    struct bej_arena_block *b = arena->head;
+    while (b) {
+        struct bej_arena_block *next = b->next;
+        free(b);
+        b = next;
+    }
+    arena->head = NULL;
+    arena->current = NULL;
+}
+
+struct bej_context* bej_context_create(size_t max_depth, const struct bej_budget *budget) {
+    if (max_depth == 0) return NULL;
+
+    struct bej_context *ctx = calloc(1, sizeof(struct bej_context));
+    if (!ctx) return NULL;
+    ctx->arena.block_size = BEJ_ARENA_BLOCK_SIZE;
+    if (budget) ctx->budget = *budget;
+
+    // The implicit root Set takes one frame on top of max_depth
+    if (!bej_stack_init(&ctx->stack, max_depth + 1)) { free(ctx); return NULL; }
+
+    ctx->out.capacity = 1024;
+    ctx->out.data = malloc(ctx->out.capacity);
+    if (!ctx->out.data) { bej_context_free(ctx); return NULL; }
+
+    bej_context_reset(ctx);
+    return ctx;
+}
+
+void bej_context_free(struct bej_context *ctx) {
+    if (!ctx) return;
+    arena_free(&ctx->arena);
+    bej_stack_free(&ctx->stack);
+    free(ctx->out.data);
+    free(ctx->scratch);
+    free(ctx);
+}
+
+void bej_context_reset(struct bej_context *ctx) {
+    if (!ctx) return;
+    arena_reset(&ctx->arena);
+    ctx->nodes = 0;
+    ctx->status = BEJ_CONTEXT_OK;
+    ctx->out.length = 0;
+    ctx->out.data[0] = '\0';
+    ctx->out.limit = ctx->budget.max_output;
+    ctx->out.overflow = false;
+}
+
+unsigned char* bej_context_scratch(struct bej_context *ctx, size_t size) {
+    if (!ctx) return NULL;
+    if (size > ctx->scratch_capacity) {
+        size_t capacity = ctx->scratch_capacity ? ctx->scratch_capacity : 4096;
+        while (capacity < size) capacity *= 2;
+        unsigned char *tmp = realloc(ctx->scratch, capacity);
+        if (!tmp) return NULL;
+        ctx->scratch = tmp;
+        ctx->scratch_capacity = capacity;
+    }
+    return ctx->scratch;
+}
+
+struct bej_node* bej_context_parse(struct bej_context *ctx, unsigned char *data, size_t data_len) {
+    if (!ctx) return NULL;
+    bej_context_reset(ctx);
+    return parse_sflv_init_context(data, data_len, ctx);
+}
+
+enum bej_context_status bej_context_convert(struct bej_context *ctx, unsigned char *data, size_t data_len,
+                                            enum bej_output_format format, unsigned flags,
+                                            struct field_map *map, size_t map_count) {
+    if (!ctx) return BEJ_CONTEXT_NO_MEMORY;
+
+    struct bej_node *root = bej_context_parse(ctx, data, data_len);
+    if (ctx->status != BEJ_CONTEXT_OK) return ctx->status;
+    if (!root) return BEJ_CONTEXT_OK;
+
+    if (bej_write_node(root, &ctx->out, format, flags, map, map_count, &ctx->stack) < 0)
+        ctx->status = BEJ_CONTEXT_TOO_DEEP;
+    if (ctx->out.overflow) ctx->status = BEJ_CONTEXT_OUTPUT_BUDGET;
+    return ctx->status;
+}
+
+const char* bej_context_strerror(enum bej_context_status status) {
+    switch (status) {
+        case BEJ_CONTEXT_OK:            return "ok";
+        case BEJ_CONTEXT_TOO_DEEP:      return "nesting exceeds the depth limit";
+        case BEJ_CONTEXT_NODE_BUDGET:   return "node budget exceeded";
+        case BEJ_CONTEXT_STRING_BUDGET: return "string budget exceeded";
+        case BEJ_CONTEXT_OUTPUT_BUDGET: return "output budget exceeded";
+        case BEJ_CONTEXT_NO_MEMORY:     return "out of memory";
+        default:                        return "unknown error";
+    }
+}
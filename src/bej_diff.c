@@ -0,0 +1,252 @@
+/**
+ * @file bej_diff.c
+ * @brief Structural BEJ diff implementation - emits RFC 6902 JSON Patch
+ */
+
+#include "bej_diff.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+/** Location of one encoded SFLV tuple inside a snapshot */
+struct tuple_span {
+    struct bej_sflv_header hdr;  /**< Decoded tuple header */
+    unsigned char *start;        /**< First byte of the tuple */
+    unsigned char *value;        /**< First byte of the value */
+    unsigned char *end;          /**< One past the last byte of the value */
+    bool matched;                /**< Paired with a tuple of the other snapshot */
+};
+
+/** State shared by the whole diff walk */
+struct diff_state {
+    struct field_map *map;         /**< Field map for member names */
+    size_t map_count;              /**< Number of entries in field map */
+    struct dynamic_string *out;    /**< JSON Patch output */
+    struct dynamic_string *path;   /**< JSON Pointer of the current value */
+    struct bej_stack *stack;       /**< Bounds the nesting depth; also used to render values */
+    size_t depth;                  /**< Set/Array levels entered so far */
+    int ops;                       /**< Operations emitted so far */
+};
+
+static int collect_tuples(unsigned char *data, unsigned char *data_end,
+                          struct tuple_span **spans, size_t *count) {
+    size_t capacity = 0;
+    *spans = NULL;
+    *count = 0;
+
+    while (data < data_end) {
+        struct tuple_span t;
+        t.start = data;
+        if (!read_sflv_header(&data, data_end, &t.hdr) ||
+            t.hdr.length > (size_t)(data_end - data)) {
+            free(*spans);
+            *spans = NULL;
+            return -1;
+        }
+        t.value = data;
+        data += t.hdr.length;
+        t.end = data;
+        t.matched = false;
+
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            struct tuple_span *tmp = realloc(*spans, capacity * sizeof(struct tuple_span));
+            if (!tmp) { perror("realloc"); free(*spans); *spans = NULL; return -1; }
+            *spans = tmp;
+        }
+        (*spans)[(*count)++] = t;
+    }
+    return 0;
+}
+
+static void path_push(struct dynamic_string *path, const char *segment) {
+    char buf[2] = {0};
+    dynamic_string_append(path, "/");
+    for (const char *c = segment; *c; c++) {
+        switch (*c) {
+            case '~':  dynamic_string_append(path, "~0"); break;
+            case '/':  dynamic_string_append(path, "~1"); break;
+            case '"':  dynamic_string_append(path, "\\\""); break;
+            case '\\': dynamic_string_append(path, "\\\\"); break;
+            default:
+                buf[0] = *c;
+                dynamic_string_append(path, buf);
+                break;
+        }
+    }
+}
+
+static void path_push_member(struct diff_state *st, const struct tuple_span *t) {
+    const char *name = get_field_name(t->hdr.sequence, st->map, st->map_count);
+    char fallback[64];
+    if (!name) {
+        snprintf(fallback, sizeof(fallback), "field_%" PRIu64, t->hdr.sequence);
+        name = fallback;
+    }
+    path_push(st->path, name);
+}
+
+static void path_push_index(struct diff_state *st, size_t index) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%zu", index);
+    path_push(st->path, buf);
+}
+
+static void path_pop(struct dynamic_string *path, size_t length) {
+    path->length = length;
+    path->data[length] = '\0';
+}
+
+static int render_value(struct diff_state *st, const struct tuple_span *t) {
+    // The value may only use the levels the walk has not already entered
+    size_t room = st->stack->max_depth - st->depth;
+    if (room == 0 && (t->hdr.format == BEJ_FORMAT_SET || t->hdr.format == BEJ_FORMAT_ARRAY))
+        return -1;
+    // Scalars take no frame, so a spare level is never touched
+    struct bej_stack rest = { st->stack->frames, room ? room : 1 };
+
+    struct bej_node *node = calloc(1, sizeof(struct bej_node));
+    if (!node) { perror("calloc"); exit(1); }
+    unsigned char *ptr = t->start;
+    int rc = parse_sflv_stack(node, &ptr, t->end, &rest);
+    if (rc == 0) rc = bej_node_to_str_stack(node, st->out, NULL, 0, st->map, st->map_count, &rest);
+    free_bej_node(node);
+    return rc;
+}
+
+static int emit_op(struct diff_state *st, const char *op, const struct tuple_span *value) {
+    dynamic_string_append(st->out, st->ops++ ? ",\n  " : "\n  ");
+    dynamic_string_append(st->out, "{\"op\": \"");
+    dynamic_string_append(st->out, op);
+    dynamic_string_append(st->out, "\", \"path\": \"");
+    dynamic_string_append(st->out, st->path->data);
+    dynamic_string_append(st->out, "\"");
+    int rc = 0;
+    if (value) {
+        dynamic_string_append(st->out, ", \"value\": ");
+        rc = render_value(st, value);
+    }
+    dynamic_string_append(st->out, "}");
+    return rc;
+}
+
+static int diff_members(struct diff_state *st,
+                        unsigned char *prev, unsigned char *prev_end,
+                        unsigned char *cur, unsigned char *cur_end, bool is_array);
+
+static int diff_pair(struct diff_state *st, const struct tuple_span *a, const struct tuple_span *b) {
+    size_t a_len = (size_t)(a->end - a->start);
+    size_t b_len = (size_t)(b->end - b->start);
+
+    // Unchanged subtrees are skipped without being decoded
+    if (a_len == b_len && memcmp(a->start, b->start, a_len) == 0) return 0;
+
+    if (a->hdr.format == b->hdr.format &&
+        (a->hdr.format == BEJ_FORMAT_SET || a->hdr.format == BEJ_FORMAT_ARRAY)) {
+        // Every level costs a C frame; stop where the decoder would
+        if (st->depth >= st->stack->max_depth) return -1;
+        st->depth++;
+        int rc = diff_members(st, a->value, a->end, b->value, b->end, a->hdr.format == BEJ_FORMAT_ARRAY);
+        st->depth--;
+        return rc;
+    }
+
+    return emit_op(st, "replace", b);
+}
+
+static int diff_members(struct diff_state *st,
+                        unsigned char *prev, unsigned char *prev_end,
+                        unsigned char *cur, unsigned char *cur_end, bool is_array) {
+    struct tuple_span *a = NULL, *b = NULL;
+    size_t na = 0, nb = 0;
+    if (collect_tuples(prev, prev_end, &a, &na) < 0) return -1;
+    if (collect_tuples(cur, cur_end, &b, &nb) < 0) { free(a); return -1; }
+
+    size_t saved = st->path->length;
+    int rc = 0;
+
+    if (is_array) {
+        size_t common = na < nb ? na : nb;
+        for (size_t i = 0; i < common && rc == 0; i++) {
+            path_push_index(st, i);
+            rc = diff_pair(st, &a[i], &b[i]);
+            path_pop(st->path, saved);
+        }
+        for (size_t i = common; i < nb && rc == 0; i++) {
+            path_push_index(st, i);
+            rc = emit_op(st, "add", &b[i]);
+            path_pop(st->path, saved);
+        }
+        // Remove from the tail so earlier indices stay valid
+        for (size_t i = na; i-- > nb && rc == 0;) {
+            path_push_index(st, i);
+            emit_op(st, "remove", NULL);
+            path_pop(st->path, saved);
+        }
+    } else {
+        for (size_t j = 0; j < nb && rc == 0; j++) {
+            struct tuple_span *match = NULL;
+            // Members usually keep their position, so try the same index first
+            if (j < na && !a[j].matched && a[j].hdr.sequence == b[j].hdr.sequence &&
+                a[j].hdr.dictionary_type == b[j].hdr.dictionary_type) {
+                match = &a[j];
+            } else {
+                for (size_t i = 0; i < na; i++) {
+                    if (!a[i].matched && a[i].hdr.sequence == b[j].hdr.sequence &&
+                        a[i].hdr.dictionary_type == b[j].hdr.dictionary_type) {
+                        match = &a[i];
+                        break;
+                    }
+                }
+            }
+
+            path_push_member(st, &b[j]);
+            if (match) {
+                match->matched = true;
+                rc = diff_pair(st, match, &b[j]);
+            } else {
+                rc = emit_op(st, "add", &b[j]);
+            }
+            path_pop(st->path, saved);
+        }
+        for (size_t i = 0; i < na && rc == 0; i++) {
+            if (a[i].matched) continue;
+            path_push_member(st, &a[i]);
+            emit_op(st, "remove", NULL);
+            path_pop(st->path, saved);
+        }
+    }
+
+    free(a);
+    free(b);
+    return rc;
+}
+
+int bej_diff(unsigned char *prev, size_t prev_len,
+             unsigned char *cur, size_t cur_len,
+             struct field_map *map, size_t map_count,
+             struct dynamic_string *out) {
+    struct bej_frame frames[BEJ_DEFAULT_MAX_DEPTH];
+    struct bej_stack stack = { frames, BEJ_DEFAULT_MAX_DEPTH };
+    return bej_diff_stack(prev, prev_len, cur, cur_len, map, map_count, &stack, out);
+}
+
+int bej_diff_stack(unsigned char *prev, size_t prev_len,
+                   unsigned char *cur, size_t cur_len,
+                   struct field_map *map, size_t map_count,
+                   struct bej_stack *stack, struct dynamic_string *out) {
+    if (!prev || !cur || !out || !stack || !stack->frames) return -1;
+
+    struct diff_state st = { map, map_count, out, dynamic_string_init(), stack, 0, 0 };
+    int rc = 0;
+
+    dynamic_string_append(out, "[");
+    if (prev_len != cur_len || memcmp(prev, cur, cur_len) != 0)
+        rc = diff_members(&st, prev, prev + prev_len, cur, cur + cur_len, false);
+    dynamic_string_append(out, st.ops ? "\n]" : "]");
+
+    free(st.path->data);
+    free(st.path);
+    return rc < 0 ? -1 : st.ops;
+}
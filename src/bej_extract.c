@@ -0,0 +1,327 @@
+/**
+ * @file bej_extract.c
+ * @brief Columnar field extraction implementation
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "bej_extract.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+/** Value found for one column while scanning a document */
+struct pending_value {
+    bool found;                  /**< Path matched in this document */
+    enum bej_column_type type;   /**< Value type, UNSET for null */
+    int64_t value;               /**< Integer, enum or boolean value */
+    unsigned char *str;          /**< String bytes inside the document */
+    size_t str_len;              /**< String length without terminator */
+};
+
+static bool resolve_name(const char *name, size_t len, struct field_map *map, size_t map_count, uint64_t *seq) {
+    for (size_t i = 0; i < map_count; i++) {
+        if (map[i].name && strlen(map[i].name) == len && memcmp(map[i].name, name, len) == 0) {
+            *seq = map[i].sequence;
+            return true;
+        }
+    }
+    // Accept the writer's fallback spelling for unnamed members
+    if (len > 6 && memcmp(name, "field_", 6) == 0) {
+        char *end;
+        *seq = strtoull(name + 6, &end, 10);
+        return end == name + len;
+    }
+    return false;
+}
+
+static bool grow_column(struct bej_column *col, size_t rows) {
+    if (rows < col->capacity) return true;
+
+    size_t capacity = col->capacity ? col->capacity * 2 : 256;
+    int64_t *values = realloc(col->values, capacity * sizeof(int64_t));
+    if (!values) return false;
+    col->values = values;
+    uint8_t *valid = realloc(col->valid, capacity);
+    if (!valid) return false;
+    col->valid = valid;
+    uint32_t *offsets = realloc(col->str_offsets, (capacity + 1) * sizeof(uint32_t));
+    if (!offsets) return false;
+    col->str_offsets = offsets;
+    col->capacity = capacity;
+    return true;
+}
+
+struct bej_extractor* bej_extractor_create(const char **paths, size_t path_count,
+                                           struct field_map *map, size_t map_count) {
+    if (!paths || path_count == 0 || path_count > BEJ_EXTRACT_MAX_COLUMNS) return NULL;
+
+    struct bej_extractor *ex = calloc(1, sizeof(struct bej_extractor));
+    if (!ex) return NULL;
+    ex->columns = calloc(path_count, sizeof(struct bej_column));
+    if (!ex->columns) { free(ex); return NULL; }
+    ex->column_count = path_count;
+
+    for (size_t c = 0; c < path_count; c++) {
+        struct bej_column *col = &ex->columns[c];
+        col->path = strdup(paths[c]);
+        col->str_data = dynamic_string_init();
+        if (!col->path || !grow_column(col, 0)) { bej_extractor_free(ex); return NULL; }
+        col->str_offsets[0] = 0;
+
+        const char *p = paths[c];
+        while (*p) {
+            const char *slash = strchr(p, '/');
+            size_t len = slash ? (size_t)(slash - p) : strlen(p);
+            if (len == 0 || col->depth == BEJ_EXTRACT_MAX_PATH_DEPTH ||
+                !resolve_name(p, len, map, map_count, &col->sequences[col->depth])) {
+                bej_extractor_free(ex);
+                return NULL;
+            }
+            col->depth++;
+            p += len;
+            if (*p == '/') p++;
+        }
+        if (col->depth == 0) { bej_extractor_free(ex); return NULL; }
+    }
+    return ex;
+}
+
+void bej_extractor_free(struct bej_extractor *ex) {
+    if (!ex) return;
+    for (size_t c = 0; c < ex->column_count; c++) {
+        struct bej_column *col = &ex->columns[c];
+        free(col->path);
+        free(col->values);
+        free(col->valid);
+        free(col->str_offsets);
+        if (col->str_data) {
+            free(col->str_data->data);
+            free(col->str_data);
+        }
+    }
+    free(ex->columns);
+    free(ex);
+}
+
+static void capture(struct pending_value *pv, const struct bej_sflv_header *hdr,
+                    unsigned char *value, unsigned char *value_end) {
+    pv->found = true;
+    pv->type = BEJ_COLUMN_UNSET;
+
+    switch (hdr->format) {
+        case BEJ_FORMAT_INTEGER:
+            if (hdr->length >= 1 && hdr->length <= 8) {
+                unsigned shift = (unsigned)(64 - hdr->length * 8);
+                pv->value = (int64_t)(read_uint64(&value, hdr->length, value_end) << shift) >> shift;
+                pv->type = BEJ_COLUMN_INT;
+            }
+            break;
+
+        case BEJ_FORMAT_ENUM:
+            {
+                uint64_t option;
+                if (read_nnint(&value, value_end, &option)) {
+                    pv->value = (int64_t)option;
+                    pv->type = BEJ_COLUMN_ENUM;
+                }
+            }
+            break;
+
+        case BEJ_FORMAT_BOOLEAN:
+            if (hdr->length >= 1) {
+                pv->value = value[0] ? 1 : 0;
+                pv->type = BEJ_COLUMN_BOOL;
+            }
+            break;
+
+        case BEJ_FORMAT_STRING:
+            pv->str = value;
+            pv->str_len = hdr->length;
+            while (pv->str_len > 0 && value[pv->str_len - 1] == '\0') pv->str_len--;
+            pv->type = BEJ_COLUMN_STRING;
+            break;
+
+        default:
+            break;
+    }
+}
+
+/** Appends one row holding the pending values; columns without one get null */
+static int append_row(struct bej_extractor *ex, const struct pending_value *pending) {
+    size_t row = ex->rows;
+    for (size_t c = 0; c < ex->column_count; c++) {
+        struct bej_column *col = &ex->columns[c];
+        const struct pending_value *pv = &pending[c];
+        if (!grow_column(col, row + 1)) { perror("realloc"); return -1; }
+
+        if (col->type == BEJ_COLUMN_UNSET && pv->found) col->type = pv->type;
+        bool valid = pv->found && pv->type != BEJ_COLUMN_UNSET && pv->type == col->type;
+
+        col->valid[row] = valid ? 1 : 0;
+        col->values[row] = valid && pv->type != BEJ_COLUMN_STRING ? pv->value : 0;
+        if (valid && pv->type == BEJ_COLUMN_STRING)
+            dynamic_string_append_len(col->str_data, pv->str, pv->str_len);
+        col->str_offsets[row + 1] = (uint32_t)col->str_data->length;
+    }
+    ex->rows++;
+    return 0;
+}
+
+int bej_extract_document(struct bej_extractor *ex, unsigned char *data, size_t data_len) {
+    if (!ex || !data) return -1;
+
+    struct pending_value pending[BEJ_EXTRACT_MAX_COLUMNS];
+    memset(pending, 0, ex->column_count * sizeof(struct pending_value));
+
+    unsigned char *ptr = data;
+    unsigned char *limit = data + data_len;
+
+    // Paths are relative to the resource, so step into a lone top-level Set
+    {
+        unsigned char *p = data;
+        struct bej_sflv_header hdr;
+        if (read_sflv_header(&p, limit, &hdr) && hdr.format == BEJ_FORMAT_SET &&
+            hdr.length == (size_t)(limit - p))
+            ptr = p;
+    }
+
+    struct { unsigned char *end; uint64_t live; } stack[BEJ_EXTRACT_MAX_PATH_DEPTH];
+    size_t depth = 0;
+    uint64_t live = ex->column_count == 64 ? UINT64_MAX : (UINT64_C(1) << ex->column_count) - 1;
+
+    for (;;) {
+        if (ptr == limit) {
+            if (depth == 0) break;
+            depth--;
+            limit = stack[depth].end;
+            live = stack[depth].live;
+            continue;
+        }
+
+        struct bej_sflv_header hdr;
+        if (!read_sflv_header(&ptr, limit, &hdr) || hdr.length > (size_t)(limit - ptr)) return -1;
+        unsigned char *value = ptr;
+        unsigned char *next = ptr + hdr.length;
+
+        uint64_t deeper = 0;
+        if (hdr.dictionary_type == 0) {
+            for (uint64_t m = live; m; m &= m - 1) {
+                int c = __builtin_ctzll(m);
+                struct bej_column *col = &ex->columns[c];
+                if (col->sequences[depth] != hdr.sequence) continue;
+                if (col->depth == depth + 1) {
+                    if (!pending[c].found) capture(&pending[c], &hdr, value, next);
+                } else {
+                    deeper |= UINT64_C(1) << c;
+                }
+            }
+        }
+
+        if (deeper && hdr.format == BEJ_FORMAT_SET) {
+            stack[depth].end = limit;
+            stack[depth].live = live;
+            depth++;
+            limit = next;
+            live = deeper;
+            continue;
+        }
+
+        // Nothing requested below this tuple: skip it by its length
+        ptr = next;
+    }
+
+    // Commit the row only once the whole document scanned cleanly
+    return append_row(ex, pending);
+}
+
+int bej_extract_null_row(struct bej_extractor *ex) {
+    if (!ex) return -1;
+    struct pending_value pending[BEJ_EXTRACT_MAX_COLUMNS];
+    memset(pending, 0, ex->column_count * sizeof(struct pending_value));
+    return append_row(ex, pending);
+}
+
+static void append_csv_string(struct dynamic_string *out, const char *s, size_t len) {
+    bool quote = false;
+    for (size_t i = 0; i < len && !quote; i++)
+        quote = s[i] == ',' || s[i] == '"' || s[i] == '\n' || s[i] == '\r';
+    if (!quote) { dynamic_string_append_len(out, s, len); return; }
+
+    dynamic_string_append(out, "\"");
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] == '"') dynamic_string_append(out, "\"\"");
+        else dynamic_string_append_len(out, &s[i], 1);
+    }
+    dynamic_string_append(out, "\"");
+}
+
+void bej_extractor_write_csv(const struct bej_extractor *ex, struct dynamic_string *out) {
+    if (!ex || !out) return;
+
+    for (size_t c = 0; c < ex->column_count; c++) {
+        if (c) dynamic_string_append(out, ",");
+        append_csv_string(out, ex->columns[c].path, strlen(ex->columns[c].path));
+    }
+    dynamic_string_append(out, "\n");
+
+    char buf[32];
+    for (size_t r = 0; r < ex->rows; r++) {
+        for (size_t c = 0; c < ex->column_count; c++) {
+            const struct bej_column *col = &ex->columns[c];
+            if (c) dynamic_string_append(out, ",");
+            if (!col->valid[r]) continue;
+
+            switch (col->type) {
+                case BEJ_COLUMN_INT:
+                    snprintf(buf, sizeof(buf), "%" PRId64, col->values[r]);
+                    dynamic_string_append(out, buf);
+                    break;
+                case BEJ_COLUMN_ENUM:
+                    snprintf(buf, sizeof(buf), "%" PRIu64, (uint64_t)col->values[r]);
+                    dynamic_string_append(out, buf);
+                    break;
+                case BEJ_COLUMN_BOOL:
+                    dynamic_string_append(out, col->values[r] ? "true" : "false");
+                    break;
+                case BEJ_COLUMN_STRING:
+                    append_csv_string(out, col->str_data->data + col->str_offsets[r],
+                                      col->str_offsets[r + 1] - col->str_offsets[r]);
+                    break;
+                default:
+                    break;
+            }
+        }
+        dynamic_string_append(out, "\n");
+    }
+}
+
+static void put_le(struct dynamic_string *out, uint64_t v, size_t n) {
+    unsigned char buf[8];
+    for (size_t i = 0; i < n; i++) buf[i] = (unsigned char)(v >> (8 * i));
+    dynamic_string_append_len(out, buf, n);
+}
+
+void bej_extractor_write_binary(const struct bej_extractor *ex, struct dynamic_string *out) {
+    if (!ex || !out) return;
+
+    dynamic_string_append_len(out, "BEJCOL01", 8);
+    put_le(out, ex->column_count, 4);
+    put_le(out, ex->rows, 8);
+
+    for (size_t c = 0; c < ex->column_count; c++) {
+        const struct bej_column *col = &ex->columns[c];
+        size_t path_len = strlen(col->path);
+        put_le(out, path_len, 2);
+        dynamic_string_append_len(out, col->path, path_len);
+        put_le(out, col->type, 1);
+        dynamic_string_append_len(out, col->valid, ex->rows);
+
+        if (col->type == BEJ_COLUMN_STRING) {
+            for (size_t r = 0; r <= ex->rows; r++) put_le(out, col->str_offsets[r], 4);
+            dynamic_string_append_len(out, col->str_data->data, col->str_data->length);
+        } else {
+            for (size_t r = 0; r < ex->rows; r++) put_le(out, (uint64_t)col->values[r], 8);
+        }
+    }
+}
@@ -0,0 +1,272 @@
+/**
+ * @file bej_ingest.c
+ * @brief Read-ahead file ingestion implementation
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "bej_ingest.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+/** Buffer for one file; slot i % depth holds file i */
+struct ingest_slot {
+    unsigned char *data;         /**< Reused file buffer */
+    size_t capacity;             /**< Allocated bytes */
+    size_t size;                 /**< Bytes of the current file */
+    size_t index;                /**< File held by the slot */
+    int fd;                      /**< Open descriptor while a read is in flight */
+    int error;                   /**< errno of a failed open/read */
+    bool ready;                  /**< File fully read, waiting for the consumer */
+};
+
+struct bej_ingest {
+    char **paths;                /**< Files to read */
+    size_t count;                /**< Number of files */
+    size_t depth;                /**< Number of slots */
+    struct ingest_slot *slots;   /**< Slot ring */
+    size_t next_read;            /**< Next file to claim for reading */
+    size_t next_deliver;         /**< Next file to hand to the consumer */
+    bool stop;                   /**< Readers must exit */
+    pthread_mutex_t lock;        /**< Protects the counters and slot states */
+    pthread_cond_t space;        /**< A slot was released or stop was set */
+    pthread_cond_t filled;       /**< A slot became ready */
+    pthread_t *threads;          /**< Reader threads */
+    size_t thread_count;         /**< Number of reader threads */
+#ifdef HAVE_LIBURING
+    struct io_uring ring;        /**< Submission/completion rings */
+    bool use_uring;              /**< io_uring backend selected */
+#endif
+};
+
+/** Opens the file of a claimed slot and sizes its buffer; false on error */
+static bool prepare_slot(struct bej_ingest *in, struct ingest_slot *slot, size_t index) {
+    slot->index = index;
+    slot->size = 0;
+    slot->error = 0;
+    slot->fd = open(in->paths[index], O_RDONLY);
+    if (slot->fd < 0) { slot->error = errno; return false; }
+
+    struct stat st;
+    if (fstat(slot->fd, &st) != 0) { slot->error = errno; close(slot->fd); slot->fd = -1; return false; }
+    slot->size = (size_t)st.st_size;
+
+    if (slot->size > slot->capacity || !slot->data) {
+        size_t capacity = slot->size ? slot->size : 1;
+        unsigned char *tmp = realloc(slot->data, capacity);
+        if (!tmp) { slot->error = ENOMEM; close(slot->fd); slot->fd = -1; return false; }
+        slot->data = tmp;
+        slot->capacity = capacity;
+    }
+    return true;
+}
+
+/** Reads the rest of a prepared slot's file with blocking reads and closes it */
+static void finish_slot(struct ingest_slot *slot, size_t offset) {
+    while (slot->error == 0 && offset < slot->size) {
+        ssize_t n = pread(slot->fd, slot->data + offset, slot->size - offset, (off_t)offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) slot->error = errno;
+        else if (n == 0) slot->error = EIO; // File shrank under us
+        else offset += (size_t)n;
+    }
+    close(slot->fd);
+    slot->fd = -1;
+}
+
+static void mark_ready(struct bej_ingest *in, struct ingest_slot *slot) {
+    pthread_mutex_lock(&in->lock);
+    slot->ready = true;
+    pthread_cond_broadcast(&in->filled);
+    pthread_mutex_unlock(&in->lock);
+}
+
+/** Claims the next file once its slot is free; false when there is nothing left */
+static bool claim(struct bej_ingest *in, size_t *index) {
+    pthread_mutex_lock(&in->lock);
+    while (!in->stop && in->next_read < in->count && in->next_read - in->next_deliver >= in->depth)
+        pthread_cond_wait(&in->space, &in->lock);
+    bool ok = !in->stop && in->next_read < in->count;
+    if (ok) *index = in->next_read++;
+    pthread_mutex_unlock(&in->lock);
+    return ok;
+}
+
+static void* reader_thread(void *arg) {
+    struct bej_ingest *in = arg;
+    size_t index;
+    while (claim(in, &index)) {
+        struct ingest_slot *slot = &in->slots[index % in->depth];
+        if (prepare_slot(in, slot, index)) finish_slot(slot, 0);
+        mark_ready(in, slot);
+    }
+    return NULL;
+}
+
+#ifdef HAVE_LIBURING
+static void* uring_thread(void *arg) {
+    struct bej_ingest *in = arg;
+    size_t inflight = 0;
+
+    for (;;) {
+        // Queue a read for every slot the consumer has released
+        pthread_mutex_lock(&in->lock);
+        while (!in->stop && in->next_read < in->count && in->next_read - in->next_deliver < in->depth) {
+            size_t index = in->next_read++;
+            struct ingest_slot *slot = &in->slots[index % in->depth];
+            pthread_mutex_unlock(&in->lock);
+
+            if (prepare_slot(in, slot, index) && slot->size > 0) {
+                struct io_uring_sqe *sqe = io_uring_get_sqe(&in->ring);
+                // Reads larger than one request are finished by finish_slot()
+                unsigned len = slot->size > (1u << 30) ? (1u << 30) : (unsigned)slot->size;
+                io_uring_prep_read(sqe, slot->fd, slot->data, len, 0);
+                io_uring_sqe_set_data(sqe, slot);
+                inflight++;
+            } else {
+                if (slot->fd >= 0) { close(slot->fd); slot->fd = -1; }
+                mark_ready(in, slot);
+            }
+            pthread_mutex_lock(&in->lock);
+        }
+        bool done = in->next_read == in->count || in->stop;
+        if (inflight == 0 && !done) pthread_cond_wait(&in->space, &in->lock);
+        pthread_mutex_unlock(&in->lock);
+        if (inflight == 0) {
+            if (done) break;
+            continue;
+        }
+
+        io_uring_submit(&in->ring);
+        struct io_uring_cqe *cqe;
+        int rc = io_uring_wait_cqe(&in->ring, &cqe);
+        if (rc == -EINTR) continue;
+        if (rc < 0) {
+            // Ring failure: complete whatever is still in flight synchronously
+            for (size_t i = 0; i < in->depth; i++) {
+                struct ingest_slot *slot = &in->slots[i];
+                if (slot->fd < 0) continue;
+                finish_slot(slot, 0);
+                mark_ready(in, slot);
+            }
+            inflight = 0;
+            continue;
+        }
+
+        struct ingest_slot *slot = io_uring_cqe_get_data(cqe);
+        if (cqe->res < 0) slot->error = -cqe->res;
+        // Short reads are finished with blocking reads
+        finish_slot(slot, cqe->res > 0 ? (size_t)cqe->res : 0);
+        io_uring_cqe_seen(&in->ring, cqe);
+        inflight--;
+        mark_ready(in, slot);
+    }
+    return NULL;
+}
+#endif
+
+struct bej_ingest* bej_ingest_open(char **paths, size_t count, size_t depth, size_t threads) {
+    if (!paths && count) return NULL;
+    if (depth == 0) depth = BEJ_INGEST_DEFAULT_DEPTH;
+    if (threads == 0) threads = BEJ_INGEST_DEFAULT_THREADS;
+    if (threads > depth) threads = depth;
+
+    struct bej_ingest *in = calloc(1, sizeof(struct bej_ingest));
+    if (!in) return NULL;
+    in->paths = paths;
+    in->count = count;
+    in->depth = depth;
+    in->slots = calloc(depth, sizeof(struct ingest_slot));
+    in->threads = calloc(threads, sizeof(pthread_t));
+    if (!in->slots || !in->threads) { free(in->slots); free(in->threads); free(in); return NULL; }
+    for (size_t i = 0; i < depth; i++) in->slots[i].fd = -1;
+
+    pthread_mutex_init(&in->lock, NULL);
+    pthread_cond_init(&in->space, NULL);
+    pthread_cond_init(&in->filled, NULL);
+
+    void *(*reader)(void*) = reader_thread;
+#ifdef HAVE_LIBURING
+    // Fall back to the thread pool when io_uring is unavailable (old kernel, seccomp)
+    if (io_uring_queue_init((unsigned)depth, &in->ring, 0) == 0) {
+        in->use_uring = true;
+        reader = uring_thread;
+        threads = 1;
+    }
+#endif
+
+    for (size_t i = 0; i < threads; i++) {
+        if (pthread_create(&in->threads[i], NULL, reader, in) != 0) break;
+        in->thread_count++;
+    }
+    if (in->thread_count == 0) { bej_ingest_close(in); return NULL; }
+    return in;
+}
+
+bool bej_ingest_next(struct bej_ingest *in, struct bej_ingest_buffer *buf) {
+    if (!in || !buf) return false;
+
+    pthread_mutex_lock(&in->lock);
+    if (in->next_deliver == in->count) { pthread_mutex_unlock(&in->lock); return false; }
+    struct ingest_slot *slot = &in->slots[in->next_deliver % in->depth];
+    while (!slot->ready) pthread_cond_wait(&in->filled, &in->lock);
+    pthread_mutex_unlock(&in->lock);
+
+    buf->path = in->paths[slot->index];
+    buf->index = slot->index;
+    buf->data = slot->data;
+    buf->size = slot->error ? 0 : slot->size;
+    buf->error = slot->error;
+    return true;
+}
+
+void bej_ingest_release(struct bej_ingest *in, struct bej_ingest_buffer *buf) {
+    if (!in || !buf) return;
+
+    pthread_mutex_lock(&in->lock);
+    in->slots[buf->index % in->depth].ready = false;
+    in->next_deliver++;
+    pthread_cond_broadcast(&in->space);
+    pthread_mutex_unlock(&in->lock);
+}
+
+void bej_ingest_close(struct bej_ingest *in) {
+    if (!in) return;
+
+    pthread_mutex_lock(&in->lock);
+    in->stop = true;
+    pthread_cond_broadcast(&in->space);
+    pthread_mutex_unlock(&in->lock);
+    for (size_t i = 0; i < in->thread_count; i++) pthread_join(in->threads[i], NULL);
+
+#ifdef HAVE_LIBURING
+    if (in->use_uring) io_uring_queue_exit(&in->ring);
+#endif
+    for (size_t i = 0; i < in->depth; i++) {
+        if (in->slots[i].fd >= 0) close(in->slots[i].fd);
+        free(in->slots[i].data);
+    }
+    pthread_cond_destroy(&in->filled);
+    pthread_cond_destroy(&in->space);
+    pthread_mutex_destroy(&in->lock);
+    free(in->threads);
+    free(in->slots);
+    free(in);
+}
+
+const char* bej_ingest_backend(const struct bej_ingest *in) {
+#ifdef HAVE_LIBURING
+    if (in && in->use_uring) return "io_uring";
+#else
+    (void)in;
+#endif
+    return "threads";
+}
@@ -5,6 +5,9 @@
 
 #define _POSIX_C_SOURCE 200809L
 #include "bej_parser.h"
+#include "bej_context.h"
+#include "bej_strpool.h"
+#include "bej_trace.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -12,6 +15,7 @@
 #include <string.h>
 #include <inttypes.h>
 
+static bool make_field_key(struct field_map *entry, bool pooled);
 
 struct field_map* load_map(const char *map_path, size_t *count) {
     if (!map_path || !count) return NULL;
@@ -30,17 +34,29 @@ struct field_map* load_map(const char *map_path, size_t *count) {
 
         uint64_t seq = strtoull(line, NULL, 10);
         char *name = colon + 1;
+        while (*name == ' ' || *name == '\t') name++;
 
         char *newline = strchr(name, '\n');
         if (newline) *newline = '\0';
+        size_t name_len = strlen(name);
+        while (name_len > 0 && (name[name_len - 1] == ' ' || name[name_len - 1] == '\r'))
+            name[--name_len] = '\0';
 
         struct field_map *tmp = realloc(map, (*count + 1) * sizeof(struct field_map));
         if (!tmp) { perror("realloc"); free_map(map, *count); fclose(f); return NULL; }
         map = tmp;
 
+        // Names and key tokens are shared with every other loaded map
         map[*count].sequence = seq;
-        map[*count].name = strdup(name);
+        map[*count].name = (char*)bej_intern(name, name_len);
+        map[*count].key = NULL;
         (*count)++;
+        if (!map[*count - 1].name || !make_field_key(&map[*count - 1], true)) {
+            perror("bej_intern");
+            free_map(map, *count);
+            fclose(f);
+            return NULL;
+        }
     }
 
     fclose(f);
@@ -49,18 +65,77 @@ struct field_map* load_map(const char *map_path, size_t *count) {
 
 void free_map(struct field_map *map, size_t count) {
     if (!map) return;
-    for (size_t i = 0; i < count; i++) free(map[i].name);
+    // Pooled names and tokens (from load_map()) stay; hand-built ones are the map's
+    for (size_t i = 0; i < count; i++) {
+        if (!bej_strpool_owns(map[i].name)) free(map[i].name);
+        if (!bej_strpool_owns(map[i].key)) free(map[i].key);
+    }
     free(map);
 }
 
-const char* get_field_name(uint64_t seq, struct field_map *map, size_t count) {
+/** Builds the key token on the heap, or in the string pool when pooled is set */
+static bool make_field_key(struct field_map *entry, bool pooled) {
+    if (!entry || !entry->name) return false;
+
+    // Worst case every byte becomes a \u00XX escape
+    size_t name_len = strlen(entry->name);
+    char *key = malloc(name_len * 6 + 5);
+    if (!key) return false;
+
+    size_t n = 0;
+    key[n++] = '"';
+    n += bej_json_escape(key + n, entry->name, name_len);
+    memcpy(key + n, "\": ", 4);
+    n += 3;
+
+    if (pooled) {
+        const char *copy = bej_intern(key, n);
+        free(key);
+        if (!copy) return false;
+        key = (char*)copy;
+    }
+    if (!bej_strpool_owns(entry->key)) free(entry->key);
+    entry->key = key;
+    entry->key_len = n;
+    return true;
+}
+
+bool build_field_key(struct field_map *entry) {
+    return make_field_key(entry, false);
+}
+
+size_t bej_json_escape(char *dst, const char *src, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    size_t n = 0;
+    for (const unsigned char *p = (const unsigned char*)src; p < (const unsigned char*)src + len; p++) {
+        if (*p == '"' || *p == '\\') {
+            dst[n++] = '\\';
+            dst[n++] = (char)*p;
+        } else if (*p < 0x20) {
+            memcpy(dst + n, "\\u00", 4);
+            dst[n + 4] = hex[*p >> 4];
+            dst[n + 5] = hex[*p & 0xF];
+            n += 6;
+        } else {
+            dst[n++] = (char)*p;
+        }
+    }
+    return n;
+}
+
+const struct field_map* get_field_entry(uint64_t seq, const struct field_map *map, size_t count) {
     if (!map) return NULL;
     for (size_t i = 0; i < count; i++)
-        if (map[i].sequence == seq) 
-            return map[i].name;
+        if (map[i].sequence == seq)
+            return &map[i];
     return NULL;
 }
 
+const char* get_field_name(uint64_t seq, struct field_map *map, size_t count) {
+    const struct field_map *entry = get_field_entry(seq, map, count);
+    return entry ? entry->name : NULL;
+}
+
 bool read_varint_safe(unsigned char **data, unsigned char *data_end, uint64_t *out) {
     if (!data || !*data || !out) return false;
 
@@ -91,159 +166,399 @@ uint64_t read_varint_u64(unsigned char **data, unsigned char *data_end) {
     return val;
 }
 
-uint64_t read_uint64(unsigned char **data, int length, unsigned char *data_end) {
-    if (*data + length > data_end) return 0;
-    uint64_t val = 0;
-    for (int i = 0; i < length; i++) {
-        val = (val << 8) | (*(*data + i));
+/**
+ * Loads n (0-8) little-endian bytes. When at least 8 bytes are readable the
+ * value comes from one unaligned 64-bit load masked to n bytes; near the
+ * end of the buffer it falls back to a byte loop.
+ */
+static inline uint64_t load_le(const unsigned char *p, size_t n, const unsigned char *data_end) {
+    if ((size_t)(data_end - p) >= sizeof(uint64_t)) {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        v = __builtin_bswap64(v);
+#endif
+        return n >= 8 ? v : v & ((UINT64_C(1) << (n * 8)) - 1);
     }
+
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++)
+        v |= (uint64_t)p[i] << (i * 8);
+    return v;
+}
+
+bool read_nnint(unsigned char **data, unsigned char *data_end, uint64_t *out) {
+    if (!data || !*data || !out || *data >= data_end) return false;
+
+    unsigned char *p = *data;
+    size_t n = p[0];
+    if (n > 8 || (size_t)(data_end - p) - 1 < n) return false;
+
+    // Single-byte values dominate sequence numbers and lengths
+    *out = n == 1 ? p[1] : load_le(p + 1, n, data_end);
+    *data = p + 1 + n;
+    return true;
+}
+
+uint64_t read_uint64(unsigned char **data, size_t length, unsigned char *data_end) {
+    if (length > (size_t)(data_end - *data)) return 0;
+    uint64_t val = load_le(*data, length, data_end);
     *data += length;
     return val;
 }
 
-int read_int(unsigned char **data, int length, unsigned char *data_end) {
-    if (*data + length > data_end) return 0;
+int read_int(unsigned char **data, size_t length, unsigned char *data_end) {
+    if (length > (size_t)(data_end - *data)) return 0;
     int val = 0;
-    for (int i = 0; i < length; i++) {
+    for (size_t i = 0; i < length; i++) {
         val = (val << 8) | (*(*data + i));
     }
     *data += length;
     return val;
 }
 
-char* read_str(unsigned char **data, int length, unsigned char *data_end) {
-    if (*data + length > data_end) return NULL;
+char* read_str(unsigned char **data, size_t length, unsigned char *data_end) {
+    // Checked before allocating: the length comes straight from the tuple header
+    if (length > (size_t)(data_end - *data)) return NULL;
     char *str = malloc(length + 1);
+    if (!str) return NULL;
     memcpy(str, *data, length);
     str[length] = '\0';
     *data += length;
     return str;
 }
 
-void parse_sflv_recursion(struct bej_node *node, unsigned char **data, unsigned char *data_end, unsigned char *schema_dict, unsigned char *buffer_start) {
-    if (!node || *data >= data_end) return;
+bool read_sflv_header(unsigned char **data, unsigned char *data_end, struct bej_sflv_header *hdr) {
+    if (!data || !*data || !hdr || *data >= data_end) return false;
+
+    unsigned char *p = *data;
+    uint64_t seq, length;
+    uint8_t format_byte;
+
+    if ((size_t)(data_end - p) >= 5 && p[0] == 1 && p[3] == 1) {
+        // Fast path: one-byte sequence and length nnints
+        seq = p[1];
+        format_byte = p[2];
+        length = p[4];
+        *data = p + 5;
+    } else {
+        if (!read_nnint(data, data_end, &seq)) return false;
+        if (*data >= data_end) return false;
+        format_byte = **data;
+        (*data)++;
+        if (!read_nnint(data, data_end, &length)) return false;
+    }
+
+    hdr->dictionary_type = seq & 1;
+    hdr->sequence = seq >> 1;
+    hdr->format = format_byte & 0x0F;
+    hdr->format_flags = (format_byte >> 4);
+    hdr->length = (size_t)length;
+    return true;
+}
 
-    uint64_t seq = read_varint_u64(data, data_end);
-    node->dictionary_type = seq & 1;
-    node->sequence = seq >> 1;
+static void skip_bytes(unsigned char **data, size_t length, unsigned char *data_end) {
+    *data = length < (size_t)(data_end - *data) ? *data + length : data_end;
+}
+
+bool bej_stack_init(struct bej_stack *stack, size_t max_depth) {
+    if (!stack || max_depth == 0) return false;
+    stack->frames = malloc(max_depth * sizeof(struct bej_frame));
+    if (!stack->frames) { perror("malloc"); return false; }
+    stack->max_depth = max_depth;
+    return true;
+}
 
-    if (*data >= data_end) return;
+void bej_stack_free(struct bej_stack *stack) {
+    if (!stack) return;
+    free(stack->frames);
+    stack->frames = NULL;
+    stack->max_depth = 0;
+}
+
+/** Allocates from the context's arena, or from the heap without a context */
+static void* value_alloc(struct bej_context *ctx, size_t size) {
+    if (!ctx) return malloc(size);
+    void *p = bej_arena_alloc(&ctx->arena, size);
+    if (!p && ctx->status == BEJ_CONTEXT_OK) ctx->status = BEJ_CONTEXT_NO_MEMORY;
+    return p;
+}
 
-    uint8_t format_byte = **data;
-    node->format = format_byte & 0x0F;
-    node->format_flags = (format_byte >> 4);
-    (*data)++;
+static char* decode_string(struct bej_context *ctx, unsigned char **data, size_t length, unsigned char *data_end) {
+    if (!ctx) return read_str(data, length, data_end);
 
-    bool is_null = (format_byte & 0x10) != 0;
-    bool is_readonly = (format_byte & 0x20) != 0;
-    uint8_t selector = (format_byte >> 6) & 0x03;
+    if (ctx->budget.max_string && length > ctx->budget.max_string) {
+        if (ctx->status == BEJ_CONTEXT_OK) ctx->status = BEJ_CONTEXT_STRING_BUDGET;
+        return NULL;
+    }
+    if (length > (size_t)(data_end - *data)) return NULL;
+    char *str = value_alloc(ctx, length + 1);
+    if (!str) return NULL;
+    memcpy(str, *data, length);
+    str[length] = '\0';
+    *data += length;
+    return str;
+}
 
-    printf("DEBUG: null=%d, readonly=%d, selector=%u\n", is_null, is_readonly, selector);
+/**
+ * Reads the tuple header into the node and decodes scalar values.
+ * Returns false when the header is incomplete.
+ */
+static bool decode_tuple(struct bej_context *ctx, struct bej_node *node, unsigned char **data, unsigned char *data_end) {
+    struct bej_sflv_header hdr = {0};
+    if (!read_sflv_header(data, data_end, &hdr)) {
+        // Nothing after a broken header can be located
+        *data = data_end;
+        return false;
+    }
+    node->dictionary_type = hdr.dictionary_type;
+    node->sequence = hdr.sequence;
 
-    node->length = read_varint_u64(data, data_end);
+    node->format = hdr.format;
+    node->format_flags = hdr.format_flags;
+    node->length = hdr.length;
 
     node->children_count = 0;
     node->children = NULL;
     node->value = NULL;
 
-    printf("DEBUG: seq=%" PRIu64 ", dict_type=%u, format_byte=0x%02X, format=%u, length=%zu\n",
-           node->sequence, node->dictionary_type, format_byte, node->format, node->length);
+#ifdef BEJ_DEBUG
+    fprintf(stderr, "DEBUG: null=%d, readonly=%d, selector=%u\n",
+            (hdr.format_flags & 0x1) != 0, (hdr.format_flags & 0x2) != 0, (hdr.format_flags >> 2) & 0x03);
+    fprintf(stderr, "DEBUG: seq=%" PRIu64 ", dict_type=%u, format=%u, length=%zu\n",
+            node->sequence, node->dictionary_type, node->format, node->length);
+#endif
+
+    unsigned char *value = *data;
 
     switch (node->format) {
         case 0:
-            *data += node->length;
             break;
             
         case 3: // BEJ_FORMAT_INTEGER
-            if (node->length == 1) {
-                int8_t *val = malloc(sizeof(int8_t));
-                *val = (int8_t)(**data);
-                (*data)++;
-                node->value = val;
-            } else if (node->length == 2) {
-                int16_t *val = malloc(sizeof(int16_t));
-                *val = (int16_t)read_uint64(data, 2, data_end);
-                node->value = val;
-            } else if (node->length == 4) {
-                int32_t *val = malloc(sizeof(int32_t));
-                *val = (int32_t)read_uint64(data, 4, data_end);
-                node->value = val;
-            } else {
-                int64_t *val = malloc(sizeof(int64_t));
-                *val = (int64_t)read_uint64(data, node->length, data_end);
-                node->value = val;
+            {
+                // Little-endian two's complement of node->length bytes
+                int64_t v = 0;
+                if (node->length >= 1 && node->length <= 8 && node->length <= (size_t)(data_end - *data)) {
+                    unsigned shift = (unsigned)(64 - node->length * 8);
+                    v = (int64_t)(read_uint64(data, node->length, data_end) << shift) >> shift;
+                }
+                if (node->length == 1) {
+                    int8_t *val = value_alloc(ctx, sizeof(int8_t));
+                    if (val) *val = (int8_t)v;
+                    node->value = val;
+                } else if (node->length == 2) {
+                    int16_t *val = value_alloc(ctx, sizeof(int16_t));
+                    if (val) *val = (int16_t)v;
+                    node->value = val;
+                } else if (node->length == 4) {
+                    int32_t *val = value_alloc(ctx, sizeof(int32_t));
+                    if (val) *val = (int32_t)v;
+                    node->value = val;
+                } else {
+                    int64_t *val = value_alloc(ctx, sizeof(int64_t));
+                    if (val) *val = v;
+                    node->value = val;
+                }
             }
             break;
             
         case 6: // BEJ_FORMAT_BOOLEAN
-            if (*data < data_end) {
-                int *val = malloc(sizeof(int));
-                *val = **data ? 1 : 0;
+            if (node->length >= 1 && *data < data_end) {
+                int *val = value_alloc(ctx, sizeof(int));
+                if (val) *val = **data ? 1 : 0;
                 (*data)++;
                 node->value = val;
             }
             break;
             
         case 5: // BEJ_FORMAT_STRING
-            node->value = read_str(data, node->length, data_end);
+            node->value = decode_string(ctx, data, node->length, data_end);
             break;
             
         case 4: // BEJ_FORMAT_ENUM
             {
-                uint64_t *val = malloc(sizeof(uint64_t));
-                *val = read_varint_u64(data, data_end);
+                uint64_t *val = value_alloc(ctx, sizeof(uint64_t));
+                if (val && !read_nnint(data, data_end, val)) *val = 0;
                 node->value = val;
             }
             break;
             
         case 1: // BEJ_FORMAT_SET
         case 2: // BEJ_FORMAT_ARRAY
-            {
-                unsigned char *end_ptr = *data + node->length;
-                while (*data < end_ptr && *data < data_end) {
-                    node->children_count++;
-                    struct bej_node **tmp = realloc(node->children, node->children_count * sizeof(struct bej_node*));
-                    if (!tmp) { perror("realloc"); exit(1); }
-                    node->children = tmp;
-
-                    node->children[node->children_count - 1] = calloc(1, sizeof(struct bej_node));
-                    parse_sflv_recursion(node->children[node->children_count - 1], data, end_ptr, schema_dict, buffer_start);
-                }
-            }
+            // Members are decoded by the caller's explicit stack
             break;
             
         default:
-            *data += node->length;
             break;
     }
+
+    if (node->format != BEJ_FORMAT_SET && node->format != BEJ_FORMAT_ARRAY) {
+        // The tuple length, not the value decoder, decides where the next tuple starts
+        *data = value;
+        skip_bytes(data, node->length, data_end);
+    }
+    return true;
 }
 
-struct bej_node* parse_sflv_init(unsigned char *data, size_t data_len, unsigned char *schema_dict) {
-    if (!data || data_len == 0) return NULL;
+static struct bej_node* new_node(struct bej_context *ctx) {
+    if (!ctx) {
+        struct bej_node *node = calloc(1, sizeof(struct bej_node));
+        if (!node) { perror("calloc"); exit(1); }
+        return node;
+    }
 
-    struct bej_node *root = calloc(1, sizeof(struct bej_node));
+    if (ctx->budget.max_nodes && ctx->nodes >= ctx->budget.max_nodes) {
+        if (ctx->status == BEJ_CONTEXT_OK) ctx->status = BEJ_CONTEXT_NODE_BUDGET;
+        return NULL;
+    }
+    struct bej_node *node = value_alloc(ctx, sizeof(struct bej_node));
+    if (!node) return NULL;
+    memset(node, 0, sizeof(struct bej_node));
+    ctx->nodes++;
+    return node;
+}
+
+/**
+ * Sizes the children array of a container whose members span [data, end).
+ * Counting mirrors decode_members(): every tuple start, including a broken
+ * trailing header, becomes one child.
+ */
+static bool alloc_children(struct bej_context *ctx, struct bej_node *parent, unsigned char *data, unsigned char *end) {
+    size_t count = 0;
+    while (data < end) {
+        struct bej_sflv_header hdr;
+        count++;
+        if (!read_sflv_header(&data, end, &hdr)) break;
+        skip_bytes(&data, hdr.length, end);
+    }
+    parent->children_count = 0;
+    parent->children = NULL;
+    if (count == 0) return true;
+
+    parent->children = value_alloc(ctx, count * sizeof(struct bej_node*));
+    if (!parent->children && !ctx) { perror("malloc"); exit(1); }
+    return parent->children != NULL;
+}
+
+static struct bej_node* append_child(struct bej_context *ctx, struct bej_node *parent) {
+    struct bej_node *child = new_node(ctx);
+    if (child) parent->children[parent->children_count++] = child;
+    return child;
+}
+
+/**
+ * Decodes members of the containers on the stack until the stack is empty.
+ * Returns -1 if a container had to be skipped because it would exceed the
+ * stack's maximum depth, or if a context budget stopped decoding.
+ */
+static int decode_members(struct bej_context *ctx, struct bej_stack *stack, size_t depth, unsigned char **data) {
+    int rc = 0;
+    while (depth > 0) {
+        struct bej_frame *frame = &stack->frames[depth - 1];
+        if (*data >= frame->end) {
+            depth--;
+            if (depth > 0) BEJ_TRACE2(container_exit, frame->node->sequence, depth);
+            continue;
+        }
+
+        struct bej_node *child = append_child(ctx, frame->node);
+        if (!child) return -1;
+        bool complete = decode_tuple(ctx, child, data, frame->end);
+        if (ctx && ctx->status != BEJ_CONTEXT_OK) return -1;
+        if (!complete) continue;
+
+        if (child->format == BEJ_FORMAT_SET || child->format == BEJ_FORMAT_ARRAY) {
+            unsigned char *end = child->length < (size_t)(frame->end - *data) ? *data + child->length : frame->end;
+            if (depth >= stack->max_depth) {
+                // Skipped containers decode as null so every writer renders them alike
+                child->format = BEJ_FORMAT_NULL;
+                child->format_flags = 0;
+                *data = end;
+                rc = -1;
+                continue;
+            }
+            if (!alloc_children(ctx, child, *data, end)) return -1;
+            BEJ_TRACE4(container_enter, child->format, child->sequence, child->length, depth);
+            stack->frames[depth].node = child;
+            stack->frames[depth].end = end;
+            stack->frames[depth].index = 0;
+            depth++;
+        }
+    }
+    return rc;
+}
+
+int parse_sflv_stack(struct bej_node *node, unsigned char **data, unsigned char *data_end, struct bej_stack *stack) {
+    if (!node || !stack || !stack->frames || *data >= data_end) return 0;
+    if (!decode_tuple(NULL, node, data, data_end)) return 0;
+    if (node->format != BEJ_FORMAT_SET && node->format != BEJ_FORMAT_ARRAY) return 0;
+
+    unsigned char *end = node->length < (size_t)(data_end - *data) ? *data + node->length : data_end;
+    if (stack->max_depth == 0) {
+        // No frame for the container itself; skip it as decode_members() would
+        node->format = BEJ_FORMAT_NULL;
+        node->format_flags = 0;
+        *data = end;
+        return -1;
+    }
+    stack->frames[0].node = node;
+    stack->frames[0].end = end;
+    stack->frames[0].index = 0;
+    alloc_children(NULL, node, *data, stack->frames[0].end);
+    return decode_members(NULL, stack, 1, data);
+}
+
+void parse_sflv_recursion(struct bej_node *node, unsigned char **data, unsigned char *data_end, unsigned char *schema_dict, unsigned char *buffer_start) {
+    (void)schema_dict;
+    (void)buffer_start;
+    struct bej_frame frames[BEJ_DEFAULT_MAX_DEPTH];
+    struct bej_stack stack = { frames, BEJ_DEFAULT_MAX_DEPTH };
+    parse_sflv_stack(node, data, data_end, &stack);
+}
+
+static struct bej_node* parse_root(struct bej_context *ctx, unsigned char *data, size_t data_len, struct bej_stack *stack) {
+    struct bej_node *root = new_node(ctx);
+    if (!root) return NULL;
     root->format = BEJ_FORMAT_SET;
     root->sequence = 0;
     root->dictionary_type = 0;
-    root->children_count = 0;
-    root->children = NULL;
-
-    unsigned char *ptr = data;
-    unsigned char *end = data + data_len;
 
-    while (ptr < end) {
-        root->children_count++;
-        struct bej_node **tmp = realloc(root->children, root->children_count * sizeof(struct bej_node*));
-        if (!tmp) { perror("realloc"); exit(1); }
-        root->children = tmp;
+    BEJ_TRACE2(document_start, data, data_len);
 
-        root->children[root->children_count - 1] = calloc(1, sizeof(struct bej_node));
-        parse_sflv_recursion(root->children[root->children_count - 1], &ptr, end, schema_dict, data);
+    // Top-level tuples are members of the implicit root Set
+    unsigned char *ptr = data;
+    int rc = -1;
+    if (alloc_children(ctx, root, data, data + data_len)) {
+        stack->frames[0].node = root;
+        stack->frames[0].end = data + data_len;
+        stack->frames[0].index = 0;
+        rc = decode_members(ctx, stack, 1, &ptr);
+        if (rc < 0 && ctx && ctx->status == BEJ_CONTEXT_OK)
+            ctx->status = BEJ_CONTEXT_TOO_DEEP;
     }
 
+    BEJ_TRACE2(document_end, data_len, rc);
     return root;
 }
 
+struct bej_node* parse_sflv_init_stack(unsigned char *data, size_t data_len, struct bej_stack *stack) {
+    if (!data || data_len == 0 || !stack || !stack->frames || stack->max_depth == 0) return NULL;
+    return parse_root(NULL, data, data_len, stack);
+}
+
+struct bej_node* parse_sflv_init_context(unsigned char *data, size_t data_len, struct bej_context *ctx) {
+    if (!data || data_len == 0 || !ctx || !ctx->stack.frames) return NULL;
+    return parse_root(ctx, data, data_len, &ctx->stack);
+}
+
+struct bej_node* parse_sflv_init(unsigned char *data, size_t data_len, unsigned char *schema_dict) {
+    (void)schema_dict;
+    struct bej_frame frames[BEJ_DEFAULT_MAX_DEPTH];
+    struct bej_stack stack = { frames, BEJ_DEFAULT_MAX_DEPTH };
+    return parse_sflv_init_stack(data, data_len, &stack);
+}
+
 void free_bej_node(struct bej_node *node) {
     if (!node) return;
     for (size_t i = 0; i < node->children_count; i++)
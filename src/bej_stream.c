@@ -0,0 +1,136 @@
+/**
+ * @file bej_stream.c
+ * @brief Multi-record BEJ stream reader implementation
+ */
+
+#include "bej_stream.h"
+#include "bej_parser.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Longest SFLV header: nnint sequence, format byte, nnint length */
+#define SFLV_HEADER_MAX  (1 + 8 + 1 + 1 + 8)
+
+void bej_stream_init(struct bej_stream *s, FILE *file, enum bej_stream_framing framing, size_t max_record) {
+    memset(s, 0, sizeof(*s));
+    s->file = file;
+    s->framing = framing;
+    // Record lengths come from the input, so there is always a finite limit
+    s->max_record = max_record && max_record < BEJ_STREAM_MAX_RECORD_CAP ? max_record : BEJ_STREAM_MAX_RECORD_CAP;
+}
+
+void bej_stream_free(struct bej_stream *s) {
+    if (!s) return;
+    free(s->buf);
+    s->buf = NULL;
+    s->capacity = 0;
+}
+
+static bool reserve(struct bej_stream *s, size_t size) {
+    if (size <= s->capacity) return true;
+    size_t capacity = s->capacity ? s->capacity : 4096;
+    while (capacity < size) {
+        if (capacity > SIZE_MAX / 2) { capacity = size; break; }
+        capacity *= 2;
+    }
+    unsigned char *tmp = realloc(s->buf, capacity);
+    if (!tmp) return false;
+    s->buf = tmp;
+    s->capacity = capacity;
+    return true;
+}
+
+static size_t read_bytes(struct bej_stream *s, void *dst, size_t n) {
+    size_t got = n ? fread(dst, 1, n, s->file) : 0;
+    s->offset += got;
+    return got;
+}
+
+/** Discards n bytes; works on pipes, where seeking does not */
+static bool skip_input(struct bej_stream *s, size_t n) {
+    unsigned char chunk[4096];
+    while (n > 0) {
+        size_t want = n < sizeof(chunk) ? n : sizeof(chunk);
+        size_t got = read_bytes(s, chunk, want);
+        if (got == 0) return false;
+        n -= got;
+    }
+    return true;
+}
+
+static uint32_t load_le32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/** Reads one SFLV header into the buffer and reports its size and the value length */
+static enum bej_stream_status read_tuple_header(struct bej_stream *s, size_t *header_len, size_t *value_len) {
+    if (!reserve(s, SFLV_HEADER_MAX)) return BEJ_STREAM_NO_MEMORY;
+
+    size_t n = 0;
+    if (read_bytes(s, s->buf, 1) == 0) return BEJ_STREAM_END;
+    if (s->buf[0] > 8) return BEJ_STREAM_BAD_HEADER;
+    n = 1;
+    size_t want = s->buf[0] + 1u;            // Sequence bytes and the format byte
+    if (read_bytes(s, s->buf + n, want + 1) != want + 1) return BEJ_STREAM_TRUNCATED;
+    n += want;
+    if (s->buf[n] > 8) return BEJ_STREAM_BAD_HEADER;
+    want = s->buf[n++];                      // Length bytes
+    if (read_bytes(s, s->buf + n, want) != want) return BEJ_STREAM_TRUNCATED;
+    n += want;
+
+    unsigned char *p = s->buf;
+    struct bej_sflv_header hdr;
+    if (!read_sflv_header(&p, s->buf + n, &hdr)) return BEJ_STREAM_BAD_HEADER;
+    *header_len = n;
+    *value_len = hdr.length;
+    return BEJ_STREAM_RECORD;
+}
+
+enum bej_stream_status bej_stream_next(struct bej_stream *s, struct bej_stream_record *rec) {
+    if (!s || !rec) return BEJ_STREAM_END;
+
+    memset(rec, 0, sizeof(*rec));
+    rec->offset = s->offset;
+
+    size_t prefix = 0;
+    size_t body = 0;
+    if (s->framing == BEJ_FRAMING_CONCAT) {
+        enum bej_stream_status status = read_tuple_header(s, &prefix, &body);
+        if (status != BEJ_STREAM_RECORD) return status;
+    } else {
+        unsigned char frame[8];
+        size_t frame_len = s->framing == BEJ_FRAMING_LENGTH_SCHEMA ? 8 : 4;
+        size_t got = read_bytes(s, frame, frame_len);
+        if (got == 0) return BEJ_STREAM_END;
+        if (got != frame_len) return BEJ_STREAM_TRUNCATED;
+        body = load_le32(frame);
+        if (s->framing == BEJ_FRAMING_LENGTH_SCHEMA) {
+            rec->schema_id = load_le32(frame + 4);
+            rec->has_schema = true;
+        }
+    }
+
+    if (body > s->max_record || body > SIZE_MAX - prefix || prefix + body > s->max_record) {
+        return skip_input(s, body) ? BEJ_STREAM_TOO_LARGE : BEJ_STREAM_TRUNCATED;
+    }
+    if (!reserve(s, prefix + body)) return BEJ_STREAM_NO_MEMORY;
+    if (read_bytes(s, s->buf + prefix, body) != body) return BEJ_STREAM_TRUNCATED;
+
+    rec->data = s->buf;
+    rec->size = prefix + body;
+    s->records++;
+    return BEJ_STREAM_RECORD;
+}
+
+const char* bej_stream_strerror(enum bej_stream_status status) {
+    switch (status) {
+        case BEJ_STREAM_RECORD:     return "record";
+        case BEJ_STREAM_END:        return "end of stream";
+        case BEJ_STREAM_TOO_LARGE:  return "record exceeds the size limit";
+        case BEJ_STREAM_TRUNCATED:  return "stream ends inside a record";
+        case BEJ_STREAM_BAD_HEADER: return "malformed tuple header";
+        case BEJ_STREAM_NO_MEMORY:  return "out of memory";
+        default:                    return "unknown error";
+    }
+}
@@ -0,0 +1,145 @@
+/**
+ * @file bej_strpool.c
+ * @brief Interned string pool implementation
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "bej_strpool.h"
+#include "bej_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/** Size of a string storage chunk; longer strings get a chunk of their own */
+#define STRPOOL_CHUNK_SIZE  (16 * 1024)
+
+/** Storage chunk; strings are packed one after another */
+struct strpool_chunk {
+    struct strpool_chunk *next;  /**< Previously filled chunk */
+    size_t size;                 /**< Usable bytes */
+    size_t used;                 /**< Bytes handed out */
+    char data[];                 /**< String bytes */
+};
+
+/** Open-addressing table slot */
+struct strpool_slot {
+    uint64_t hash;               /**< Hash of the string bytes */
+    const char *str;             /**< Pooled string, NULL if the slot is empty */
+    size_t len;                  /**< String length without terminator */
+};
+
+static struct {
+    pthread_mutex_t lock;
+    struct strpool_slot *slots;
+    size_t capacity;             /**< Number of slots, a power of two */
+    struct strpool_chunk *chunks;
+    struct bej_strpool_stats stats;
+} pool = { PTHREAD_MUTEX_INITIALIZER, NULL, 0, NULL, {0, 0, 0, 0} };
+
+static bool grow_table(void) {
+    size_t capacity = pool.capacity ? pool.capacity * 2 : 1024;
+    struct strpool_slot *slots = calloc(capacity, sizeof(struct strpool_slot));
+    if (!slots) return false;
+
+    for (size_t i = 0; i < pool.capacity; i++) {
+        struct strpool_slot *old = &pool.slots[i];
+        if (!old->str) continue;
+        size_t j = (size_t)old->hash & (capacity - 1);
+        while (slots[j].str) j = (j + 1) & (capacity - 1);
+        slots[j] = *old;
+    }
+    free(pool.slots);
+    pool.slots = slots;
+    pool.capacity = capacity;
+    return true;
+}
+
+static char* store(const char *s, size_t len) {
+    struct strpool_chunk *chunk = pool.chunks;
+    if (!chunk || chunk->size - chunk->used < len + 1) {
+        size_t size = len + 1 > STRPOOL_CHUNK_SIZE ? len + 1 : STRPOOL_CHUNK_SIZE;
+        chunk = malloc(sizeof(struct strpool_chunk) + size);
+        if (!chunk) return NULL;
+        chunk->size = size;
+        chunk->used = 0;
+        chunk->next = pool.chunks;
+        pool.chunks = chunk;
+    }
+    char *copy = chunk->data + chunk->used;
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    chunk->used += len + 1;
+    return copy;
+}
+
+const char* bej_intern(const char *s, size_t len) {
+    if (!s) return NULL;
+    uint64_t hash = bej_hash64(s, len, 0);
+
+    pthread_mutex_lock(&pool.lock);
+    pool.stats.lookups++;
+
+    // Keep the table at most three quarters full so probes stay short
+    if ((pool.stats.strings + 1) * 4 > pool.capacity * 3 && !grow_table()) {
+        pthread_mutex_unlock(&pool.lock);
+        return NULL;
+    }
+
+    size_t i = (size_t)hash & (pool.capacity - 1);
+    while (pool.slots[i].str) {
+        struct strpool_slot *slot = &pool.slots[i];
+        if (slot->hash == hash && slot->len == len && memcmp(slot->str, s, len) == 0) {
+            pool.stats.hits++;
+            pthread_mutex_unlock(&pool.lock);
+            return slot->str;
+        }
+        i = (i + 1) & (pool.capacity - 1);
+    }
+
+    const char *copy = store(s, len);
+    if (copy) {
+        pool.slots[i].hash = hash;
+        pool.slots[i].str = copy;
+        pool.slots[i].len = len;
+        pool.stats.strings++;
+        pool.stats.bytes += len + 1;
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return copy;
+}
+
+bool bej_strpool_owns(const char *s) {
+    if (!s) return false;
+    uintptr_t addr = (uintptr_t)s;
+    bool owned = false;
+
+    pthread_mutex_lock(&pool.lock);
+    for (struct strpool_chunk *chunk = pool.chunks; chunk && !owned; chunk = chunk->next)
+        owned = addr >= (uintptr_t)chunk->data && addr < (uintptr_t)(chunk->data + chunk->used);
+    pthread_mutex_unlock(&pool.lock);
+    return owned;
+}
+
+void bej_strpool_get_stats(struct bej_strpool_stats *stats) {
+    if (!stats) return;
+    pthread_mutex_lock(&pool.lock);
+    *stats = pool.stats;
+    pthread_mutex_unlock(&pool.lock);
+}
+
+void bej_strpool_clear(void) {
+    pthread_mutex_lock(&pool.lock);
+    struct strpool_chunk *chunk = pool.chunks;
+    while (chunk) {
+        struct strpool_chunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(pool.slots);
+    pool.chunks = NULL;
+    pool.slots = NULL;
+    pool.capacity = 0;
+    memset(&pool.stats, 0, sizeof(pool.stats));
+    pthread_mutex_unlock(&pool.lock);
+}
@@ -0,0 +1,102 @@
+/**
+ * @file bej_validate.c
+ * @brief Structural BEJ validation implementation
+ */
+
+#include "bej_validate.h"
+#include <stdint.h>
+
+static enum bej_validate_status fail(struct bej_validate_error *err, enum bej_validate_status status,
+                                     unsigned char *data, unsigned char *at, size_t depth) {
+    if (err) {
+        err->status = status;
+        err->offset = (size_t)(at - data);
+        err->depth = depth;
+    }
+    return status;
+}
+
+static bool length_allowed(uint8_t format, size_t length) {
+    switch (format) {
+        case BEJ_FORMAT_NULL:    return length == 0;
+        case BEJ_FORMAT_INTEGER: return length >= 1 && length <= 8;
+        case BEJ_FORMAT_ENUM:    return length >= 1;
+        case BEJ_FORMAT_BOOLEAN: return length == 1;
+        default:                 return true;
+    }
+}
+
+enum bej_validate_status bej_validate(unsigned char *data, size_t data_len,
+                                      const struct bej_validate_limits *limits,
+                                      struct bej_validate_error *err) {
+    if (!data || data_len == 0) return fail(err, BEJ_ERR_EMPTY, data, data, 0);
+
+    size_t max_depth = limits && limits->max_depth ? limits->max_depth : BEJ_VALIDATE_MAX_DEPTH;
+    if (max_depth > BEJ_VALIDATE_MAX_DEPTH) max_depth = BEJ_VALIDATE_MAX_DEPTH;
+    uint64_t max_sequence = limits ? limits->max_sequence : UINT64_MAX;
+
+    // End of every open Set/Array; the walk never allocates
+    unsigned char *ends[BEJ_VALIDATE_MAX_DEPTH];
+    size_t depth = 0;
+    unsigned char *ptr = data;
+    unsigned char *limit = data + data_len;
+
+    for (;;) {
+        if (ptr == limit) {
+            if (depth == 0) break;
+            limit = ends[--depth];
+            continue;
+        }
+
+        unsigned char *tuple = ptr;
+        struct bej_sflv_header hdr;
+        if (!read_sflv_header(&ptr, limit, &hdr))
+            return fail(err, BEJ_ERR_TRUNCATED_HEADER, data, tuple, depth);
+        if (hdr.length > (size_t)(limit - ptr))
+            return fail(err, BEJ_ERR_LENGTH_OVERRUN, data, tuple, depth);
+        if (hdr.format > BEJ_FORMAT_PROPERTY)
+            return fail(err, BEJ_ERR_BAD_FORMAT, data, tuple, depth);
+        if (hdr.dictionary_type == 0 && hdr.sequence > max_sequence)
+            return fail(err, BEJ_ERR_BAD_SEQUENCE, data, tuple, depth);
+        if (!length_allowed(hdr.format, hdr.length))
+            return fail(err, BEJ_ERR_BAD_LENGTH, data, tuple, depth);
+
+        if (hdr.format == BEJ_FORMAT_SET || hdr.format == BEJ_FORMAT_ARRAY) {
+            if (depth + 1 > max_depth)
+                return fail(err, BEJ_ERR_TOO_DEEP, data, tuple, depth);
+            ends[depth++] = limit;
+            limit = ptr + hdr.length;
+        } else {
+            ptr += hdr.length;
+        }
+    }
+
+    if (err) {
+        err->status = BEJ_VALID;
+        err->offset = data_len;
+        err->depth = 0;
+    }
+    return BEJ_VALID;
+}
+
+uint64_t bej_map_max_sequence(struct field_map *map, size_t count) {
+    if (!map || count == 0) return UINT64_MAX;
+    uint64_t max = 0;
+    for (size_t i = 0; i < count; i++)
+        if (map[i].sequence > max) max = map[i].sequence;
+    return max;
+}
+
+const char* bej_validate_strerror(enum bej_validate_status status) {
+    switch (status) {
+        case BEJ_VALID:                return "valid";
+        case BEJ_ERR_TRUNCATED_HEADER: return "truncated SFLV header";
+        case BEJ_ERR_LENGTH_OVERRUN:   return "value length exceeds parent or buffer";
+        case BEJ_ERR_BAD_FORMAT:       return "unknown format code";
+        case BEJ_ERR_BAD_LENGTH:       return "length not allowed for format";
+        case BEJ_ERR_TOO_DEEP:         return "nesting too deep";
+        case BEJ_ERR_BAD_SEQUENCE:     return "sequence number outside dictionary";
+        case BEJ_ERR_EMPTY:            return "empty payload";
+    }
+    return "unknown error";
+}
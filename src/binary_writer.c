@@ -0,0 +1,191 @@
+/**
+ * @file binary_writer.c
+ * @brief CBOR and MessagePack writer implementation
+ */
+
+#include "binary_writer.h"
+#include "bej_trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+/** Appends a lead byte followed by the low n bytes of v in big-endian order */
+static void put_be(struct dynamic_string *out, uint8_t lead, uint64_t v, size_t n) {
+    unsigned char buf[9];
+    buf[0] = lead;
+    for (size_t i = 0; i < n; i++)
+        buf[1 + i] = (unsigned char)(v >> (8 * (n - 1 - i)));
+    dynamic_string_append_len(out, buf, n + 1);
+}
+
+static void cbor_head(struct dynamic_string *out, uint8_t major, uint64_t n) {
+    uint8_t mt = (uint8_t)(major << 5);
+    if (n < 24)               put_be(out, mt | (uint8_t)n, 0, 0);
+    else if (n <= 0xFF)       put_be(out, mt | 24, n, 1);
+    else if (n <= 0xFFFF)     put_be(out, mt | 25, n, 2);
+    else if (n <= 0xFFFFFFFF) put_be(out, mt | 26, n, 4);
+    else                      put_be(out, mt | 27, n, 8);
+}
+
+static void write_uint(struct dynamic_string *out, enum bej_output_format format, uint64_t v) {
+    if (format == BEJ_OUTPUT_CBOR) { cbor_head(out, 0, v); return; }
+
+    if (v <= 0x7F)            put_be(out, (uint8_t)v, 0, 0);
+    else if (v <= 0xFF)       put_be(out, 0xCC, v, 1);
+    else if (v <= 0xFFFF)     put_be(out, 0xCD, v, 2);
+    else if (v <= 0xFFFFFFFF) put_be(out, 0xCE, v, 4);
+    else                      put_be(out, 0xCF, v, 8);
+}
+
+static void write_int(struct dynamic_string *out, enum bej_output_format format, int64_t v) {
+    if (v >= 0) { write_uint(out, format, (uint64_t)v); return; }
+    if (format == BEJ_OUTPUT_CBOR) { cbor_head(out, 1, (uint64_t)(-1 - v)); return; }
+
+    if (v >= -32)             put_be(out, (uint8_t)v, 0, 0);
+    else if (v >= INT8_MIN)   put_be(out, 0xD0, (uint64_t)v, 1);
+    else if (v >= INT16_MIN)  put_be(out, 0xD1, (uint64_t)v, 2);
+    else if (v >= INT32_MIN)  put_be(out, 0xD2, (uint64_t)v, 4);
+    else                      put_be(out, 0xD3, (uint64_t)v, 8);
+}
+
+static void write_str(struct dynamic_string *out, enum bej_output_format format, const char *s, size_t n) {
+    if (format == BEJ_OUTPUT_CBOR) {
+        cbor_head(out, 3, n);
+    } else {
+        if (n < 32)           put_be(out, 0xA0 | (uint8_t)n, 0, 0);
+        else if (n <= 0xFF)   put_be(out, 0xD9, n, 1);
+        else if (n <= 0xFFFF) put_be(out, 0xDA, n, 2);
+        else                  put_be(out, 0xDB, n, 4);
+    }
+    dynamic_string_append_len(out, s, n);
+}
+
+static void write_container(struct dynamic_string *out, enum bej_output_format format, bool is_map, size_t n) {
+    if (format == BEJ_OUTPUT_CBOR) { cbor_head(out, is_map ? 5 : 4, n); return; }
+
+    if (n < 16)               put_be(out, (is_map ? 0x80 : 0x90) | (uint8_t)n, 0, 0);
+    else if (n <= 0xFFFF)     put_be(out, is_map ? 0xDE : 0xDC, n, 2);
+    else                      put_be(out, is_map ? 0xDF : 0xDD, n, 4);
+}
+
+static void write_null(struct dynamic_string *out, enum bej_output_format format) {
+    put_be(out, format == BEJ_OUTPUT_CBOR ? 0xF6 : 0xC0, 0, 0);
+}
+
+static void write_bool(struct dynamic_string *out, enum bej_output_format format, bool v) {
+    if (format == BEJ_OUTPUT_CBOR) put_be(out, v ? 0xF5 : 0xF4, 0, 0);
+    else put_be(out, v ? 0xC3 : 0xC2, 0, 0);
+}
+
+static int64_t node_integer(const struct bej_node *node) {
+    if (!node->value) return 0;
+    switch (node->length) {
+        case 1:  return *(int8_t*)node->value;
+        case 2:  return *(int16_t*)node->value;
+        case 4:  return *(int32_t*)node->value;
+        default: return *(int64_t*)node->value;
+    }
+}
+
+static void write_scalar(struct bej_node *node, struct dynamic_string *out, enum bej_output_format format) {
+    switch (node->format) {
+        case BEJ_FORMAT_NULL:
+            write_null(out, format);
+            break;
+
+        case BEJ_FORMAT_STRING:
+            {
+                const char *s = node->value ? (const char*)node->value : "";
+                write_str(out, format, s, strlen(s));
+            }
+            break;
+
+        case BEJ_FORMAT_INTEGER:
+            write_int(out, format, node_integer(node));
+            break;
+
+        case BEJ_FORMAT_BOOLEAN:
+            write_bool(out, format, node->value && *(int*)node->value);
+            break;
+
+        case BEJ_FORMAT_ENUM:
+            if (node->value) write_uint(out, format, *(uint64_t*)node->value);
+            else write_null(out, format);
+            break;
+
+        default:
+            write_str(out, format, "<unknown>", 9);
+            break;
+    }
+}
+
+static void write_key(struct bej_node *child, struct dynamic_string *out, enum bej_output_format format,
+                      unsigned flags, struct field_map *map, size_t map_count) {
+    if (flags & BEJ_OUTPUT_INT_KEYS) {
+        write_uint(out, format, child->sequence);
+        return;
+    }
+
+    const char *name = get_field_name(child->sequence, map, map_count);
+    char child_key[64];
+    if (!name) {
+        BEJ_TRACE1(dict_miss, child->sequence);
+        snprintf(child_key, sizeof(child_key), "field_%" PRIu64, child->sequence);
+        name = child_key;
+    }
+    write_str(out, format, name, strlen(name));
+}
+
+int bej_node_to_binary_stack(struct bej_node *node, struct dynamic_string *out,
+                             enum bej_output_format format, unsigned flags,
+                             struct field_map *map, size_t map_count,
+                             struct bej_stack *stack) {
+    if (!node || !out || !stack || !stack->frames) return 0;
+
+    if (node->format != BEJ_FORMAT_SET && node->format != BEJ_FORMAT_ARRAY) {
+        write_scalar(node, out, format);
+        return 0;
+    }
+    if (stack->max_depth == 0) {
+        write_null(out, format);
+        return -1;
+    }
+
+    int rc = 0;
+    size_t depth = 0;
+
+    write_container(out, format, node->format == BEJ_FORMAT_SET, node->children_count);
+    stack->frames[depth].node = node;
+    stack->frames[depth].index = 0;
+    depth++;
+
+    while (depth > 0) {
+        struct bej_frame *frame = &stack->frames[depth - 1];
+        struct bej_node *parent = frame->node;
+
+        // Containers carry their member count up front, so closing needs no output
+        if (frame->index == parent->children_count) {
+            depth--;
+            continue;
+        }
+
+        struct bej_node *child = parent->children[frame->index++];
+        if (parent->format == BEJ_FORMAT_SET)
+            write_key(child, out, format, flags, map, map_count);
+
+        if (child->format == BEJ_FORMAT_SET || child->format == BEJ_FORMAT_ARRAY) {
+            if (depth < stack->max_depth) {
+                write_container(out, format, child->format == BEJ_FORMAT_SET, child->children_count);
+                stack->frames[depth].node = child;
+                stack->frames[depth].index = 0;
+                depth++;
+            } else {
+                write_null(out, format);
+                rc = -1;
+            }
+        } else {
+            write_scalar(child, out, format);
+        }
+    }
+    return rc;
+}
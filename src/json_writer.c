@@ -5,6 +5,8 @@
 
 #include "bej_parser.h"
 #include "json_writer.h"
+#include "binary_writer.h"
+#include "bej_trace.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -14,13 +16,15 @@ struct dynamic_string* dynamic_string_init() {
     struct dynamic_string *str = malloc(sizeof(struct dynamic_string));
     str->capacity = 1024;
     str->length = 0;
+    str->limit = 0;
+    str->overflow = false;
     str->data = malloc(str->capacity);
     str->data[0] = '\0';
     return str;
 }
 
-void dynamic_string_append(struct dynamic_string *str, const char *s) {
-    size_t slen = strlen(s);
+void dynamic_string_append_len(struct dynamic_string *str, const void *s, size_t slen) {
+    if (str->limit && slen > str->limit - str->length) { str->overflow = true; return; }
     if (str->length + slen + 1 >= str->capacity) {
         while (str->length + slen + 1 >= str->capacity) str->capacity *= 2;
         str->data = realloc(str->data, str->capacity);
@@ -30,19 +34,30 @@ void dynamic_string_append(struct dynamic_string *str, const char *s) {
     str->data[str->length] = '\0';
 }
 
-void parse_bej_node_to_str_recursion(struct bej_node *node, struct dynamic_string *str, 
-                                     const char *key, int indent,
-                                     struct field_map *map, size_t map_count) {
-    if (!node) return;
+void dynamic_string_append(struct dynamic_string *str, const char *s) {
+    dynamic_string_append_len(str, s, strlen(s));
+}
 
-    for (int i = 0; i < indent; i++) dynamic_string_append(str, "  ");
+void add_tab(struct dynamic_string *str, int tab) {
+    for (int i = 0; i < tab; i++) dynamic_string_append(str, "  ");
+}
 
-    if (key) {
-        dynamic_string_append(str, "\"");
-        dynamic_string_append(str, key);
-        dynamic_string_append(str, "\": ");
+/** Appends a string value, copying runs that need no escaping in one piece */
+static void append_escaped(struct dynamic_string *str, const char *s, size_t len) {
+    const char *run = s;
+    const char *end = s + len;
+    for (const char *p = s; p < end; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c != '"' && c != '\\' && c >= 0x20) continue;
+        char esc[6];
+        dynamic_string_append_len(str, run, (size_t)(p - run));
+        dynamic_string_append_len(str, esc, bej_json_escape(esc, p, 1));
+        run = p + 1;
     }
+    dynamic_string_append_len(str, run, (size_t)(end - run));
+}
 
+static void write_scalar(struct bej_node *node, struct dynamic_string *str) {
     switch(node->format) {
         case 0: // BEJ_FORMAT_NULL
             dynamic_string_append(str, "null");
@@ -50,7 +65,7 @@ void parse_bej_node_to_str_recursion(struct bej_node *node, struct dynamic_strin
             
         case 5: // BEJ_FORMAT_STRING
             dynamic_string_append(str, "\"");
-            dynamic_string_append(str, node->value ? (char*)node->value : "");
+            if (node->value) append_escaped(str, node->value, strlen(node->value));
             dynamic_string_append(str, "\"");
             break;
 
@@ -75,32 +90,6 @@ void parse_bej_node_to_str_recursion(struct bej_node *node, struct dynamic_strin
             dynamic_string_append(str, node->value && *(int*)node->value ? "true" : "false");
             break;
 
-        case 1: // BEJ_FORMAT_SET
-        case 2: // BEJ_FORMAT_ARRAY
-            dynamic_string_append(str, node->format == 1 ? "{\n" : "[\n");
-
-            for (size_t i = 0; i < node->children_count; i++) {
-                char child_key[64] = {0};
-
-                if (node->format == 1) { // SET
-                    const char *name = get_field_name(node->children[i]->sequence, map, map_count);
-                    if (!name) {
-                        snprintf(child_key, sizeof(child_key), "field_%" PRIu64, node->children[i]->sequence);
-                        name = child_key;
-                    }
-                    parse_bej_node_to_str_recursion(node->children[i], str, name, indent + 1, map, map_count);
-                } else { // ARRAY
-                    parse_bej_node_to_str_recursion(node->children[i], str, NULL, indent + 1, map, map_count);
-                }
-
-                if (i + 1 < node->children_count) dynamic_string_append(str, ",\n");
-                else dynamic_string_append(str, "\n");
-            }
-
-            for (int i = 0; i < indent; i++) dynamic_string_append(str, "  ");
-            dynamic_string_append(str, node->format == 1 ? "}" : "]");
-            break;
-
         case 4: // BEJ_FORMAT_ENUM
             if (node->value) {
                 char buf[32];
@@ -113,4 +102,146 @@ void parse_bej_node_to_str_recursion(struct bej_node *node, struct dynamic_strin
             dynamic_string_append(str, "\"<unknown>\"");
             break;
     }
-}
\ No newline at end of file
+}
+
+static void write_key(struct dynamic_string *str, const char *key, bool compact) {
+    dynamic_string_append(str, "\"");
+    append_escaped(str, key, strlen(key));
+    dynamic_string_append(str, compact ? "\":" : "\": ");
+}
+
+/** Writes a Set member key: the entry's prebuilt token, its name, or "field_N" */
+static void write_member_key(struct dynamic_string *str, const struct field_map *entry, uint64_t sequence,
+                             bool compact) {
+    if (entry && entry->key) {
+        // The token ends in a space that only the indented layout uses
+        dynamic_string_append_len(str, entry->key, compact ? entry->key_len - 1 : entry->key_len);
+        return;
+    }
+    if (entry && entry->name) {
+        write_key(str, entry->name, compact);
+        return;
+    }
+
+    BEJ_TRACE1(dict_miss, sequence);
+    char buf[40];
+    char *p = buf + sizeof(buf);
+    if (!compact) *--p = ' ';
+    *--p = ':';
+    *--p = '"';
+    do { *--p = (char)('0' + sequence % 10); sequence /= 10; } while (sequence);
+    p -= 7;
+    memcpy(p, "\"field_", 7);
+    dynamic_string_append_len(str, p, (size_t)(buf + sizeof(buf) - p));
+}
+
+/** Separator after a member: whether more members follow decides the comma */
+static void write_separator(struct dynamic_string *str, bool more, bool compact) {
+    if (compact) {
+        if (more) dynamic_string_append_len(str, ",", 1);
+    } else {
+        dynamic_string_append(str, more ? ",\n" : "\n");
+    }
+}
+
+static int write_json(struct bej_node *node, struct dynamic_string *str,
+                      const char *key, int indent, bool compact,
+                      struct field_map *map, size_t map_count,
+                      struct bej_stack *stack) {
+    if (!node || !stack || !stack->frames) return 0;
+
+    if (!compact) add_tab(str, indent);
+    if (key) write_key(str, key, compact);
+
+    if (node->format != BEJ_FORMAT_SET && node->format != BEJ_FORMAT_ARRAY) {
+        write_scalar(node, str);
+        return 0;
+    }
+    if (stack->max_depth == 0) {
+        dynamic_string_append(str, "null");
+        return -1;
+    }
+
+    int rc = 0;
+    size_t depth = 0;
+    const char *open_set = compact ? "{" : "{\n";
+    const char *open_array = compact ? "[" : "[\n";
+
+    dynamic_string_append(str, node->format == BEJ_FORMAT_SET ? open_set : open_array);
+    stack->frames[depth].node = node;
+    stack->frames[depth].index = 0;
+    depth++;
+
+    while (depth > 0) {
+        struct bej_frame *frame = &stack->frames[depth - 1];
+        struct bej_node *parent = frame->node;
+
+        if (frame->index == parent->children_count) {
+            // Close the container, then finish the line it sits on in its parent
+            depth--;
+            if (!compact) add_tab(str, indent + (int)depth);
+            dynamic_string_append(str, parent->format == BEJ_FORMAT_SET ? "}" : "]");
+            if (depth > 0) {
+                struct bej_frame *outer = &stack->frames[depth - 1];
+                write_separator(str, outer->index < outer->node->children_count, compact);
+            }
+            continue;
+        }
+
+        struct bej_node *child = parent->children[frame->index++];
+        if (!compact) add_tab(str, indent + (int)depth);
+
+        if (parent->format == BEJ_FORMAT_SET)
+            write_member_key(str, get_field_entry(child->sequence, map, map_count), child->sequence, compact);
+
+        if (child->format == BEJ_FORMAT_SET || child->format == BEJ_FORMAT_ARRAY) {
+            if (depth < stack->max_depth) {
+                dynamic_string_append(str, child->format == BEJ_FORMAT_SET ? open_set : open_array);
+                stack->frames[depth].node = child;
+                stack->frames[depth].index = 0;
+                depth++;
+                continue;
+            }
+            dynamic_string_append(str, "null");
+            rc = -1;
+        } else {
+            write_scalar(child, str);
+        }
+        write_separator(str, frame->index < parent->children_count, compact);
+    }
+    return rc;
+}
+
+int bej_node_to_str_stack(struct bej_node *node, struct dynamic_string *str,
+                          const char *key, int indent,
+                          struct field_map *map, size_t map_count,
+                          struct bej_stack *stack) {
+    return write_json(node, str, key, indent, false, map, map_count, stack);
+}
+
+void parse_bej_node_to_str_recursion(struct bej_node *node, struct dynamic_string *str, 
+                                     const char *key, int indent,
+                                     struct field_map *map, size_t map_count) {
+    struct bej_frame frames[BEJ_DEFAULT_MAX_DEPTH];
+    struct bej_stack stack = { frames, BEJ_DEFAULT_MAX_DEPTH };
+    bej_node_to_str_stack(node, str, key, indent, map, map_count, &stack);
+}
+
+int bej_write_node(struct bej_node *node, struct dynamic_string *out,
+                   enum bej_output_format format, unsigned flags,
+                   struct field_map *map, size_t map_count,
+                   struct bej_stack *stack) {
+    int rc;
+    switch (format) {
+        case BEJ_OUTPUT_CBOR:
+        case BEJ_OUTPUT_MSGPACK:
+            rc = bej_node_to_binary_stack(node, out, format, flags, map, map_count, stack);
+            break;
+        case BEJ_OUTPUT_JSON:
+        default:
+            rc = write_json(node, out, NULL, 0, (flags & BEJ_OUTPUT_COMPACT) != 0, map, map_count, stack);
+            break;
+    }
+    BEJ_TRACE3(writer_flush, format, out ? out->length : 0, rc);
+    return rc;
+}
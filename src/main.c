@@ -5,56 +5,571 @@
 
 #include "bej_parser.h"
 #include "json_writer.h"
+#include "bej_diff.h"
+#include "bej_cache.h"
+#include "bej_validate.h"
+#include "bej_extract.h"
+#include "bej_context.h"
+#include "bej_ingest.h"
+#include "bej_stream.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
- * @brief Main function - converts BEJ file to JSON using map file
- * @param argc Number of command line arguments
- * @param argv Command line arguments: [program] <bej_file> <map_file>
- * @return 0 on success, 1 on error
- * 
- * @usage ./bej_to_json input.bej dictionary.map
+ * @brief Read a whole file into memory
+ * @param path File path
+ * @param size Output parameter for file size in bytes
+ * @return Allocated buffer or NULL on error
  */
-int main(int argc, char *argv[]) {
-    if (argc < 3) {
-        fprintf(stderr, "Usage: %s <bej_file> <map_file>\n", argv[0]);
-        return 1;
-    }
+static unsigned char* read_file(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror("Cannot open BEJ file"); return NULL; }
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    rewind(f);
+
+    unsigned char *buf = malloc(*size ? *size : 1);
+    if (!buf) { perror("Memory allocation failed"); fclose(f); return NULL; }
+    if (fread(buf, 1, *size, f) != *size) { perror("Reading BEJ file failed"); free(buf); fclose(f); return NULL; }
+    fclose(f);
+    return buf;
+}
 
-    // Read BEJ file into memory
-    FILE *f = fopen(argv[1], "rb");
-    if (!f) { perror("Cannot open BEJ file"); return 1; }
+/**
+ * @brief Read a whole file into a context's scratch buffer
+ * @param path File path
+ * @param ctx Context whose scratch buffer receives the bytes
+ * @param size Output parameter for file size in bytes
+ * @return Scratch buffer or NULL on error
+ */
+static unsigned char* read_file_scratch(const char *path, struct bej_context *ctx, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror("Cannot open BEJ file"); return NULL; }
     fseek(f, 0, SEEK_END);
-    size_t size = ftell(f);
+    *size = ftell(f);
     rewind(f);
 
-    unsigned char *buf = malloc(size);
-    if (!buf) { perror("Memory allocation failed"); fclose(f); return 1; }
-    if (fread(buf, 1, size, f) != size) { perror("Reading BEJ file failed"); free(buf); fclose(f); return 1; }
+    unsigned char *buf = bej_context_scratch(ctx, *size ? *size : 1);
+    if (!buf) { perror("Memory allocation failed"); fclose(f); return NULL; }
+    if (fread(buf, 1, *size, f) != *size) { perror("Reading BEJ file failed"); fclose(f); return NULL; }
     fclose(f);
+    return buf;
+}
+
+/**
+ * @brief Diff mode - prints a JSON Patch between two BEJ snapshots
+ * @param prev_path Previous BEJ snapshot
+ * @param cur_path Current BEJ snapshot
+ * @param map_path Map file shared by both snapshots
+ * @param max_depth Maximum Set/Array nesting of either snapshot
+ * @return 0 on success, 1 on error
+ */
+static int run_diff(const char *prev_path, const char *cur_path, const char *map_path, size_t max_depth) {
+    size_t prev_size, cur_size;
+    unsigned char *prev = read_file(prev_path, &prev_size);
+    if (!prev) return 1;
+    unsigned char *cur = read_file(cur_path, &cur_size);
+    if (!cur) { free(prev); return 1; }
 
-    // Load field map
     size_t map_count;
-    struct field_map *map_array = load_map(argv[2], &map_count);
-    if (!map_array) { fprintf(stderr, "Failed to load map\n"); free(buf); return 1; }
+    struct field_map *map_array = load_map(map_path, &map_count);
+    if (!map_array) { fprintf(stderr, "Failed to load map\n"); free(prev); free(cur); return 1; }
 
-    // Parse BEJ and convert to JSON
-    struct bej_node *root = parse_sflv_init(buf, size, NULL);
-    if (!root) { fprintf(stderr, "BEJ parsing failed\n"); free(buf); free_map(map_array, map_count); return 1; }
+    struct bej_stack stack;
+    if (!bej_stack_init(&stack, max_depth)) {
+        perror("Memory allocation failed");
+        free(prev); free(cur); free_map(map_array, map_count);
+        return 1;
+    }
 
-    struct dynamic_string *json_str = dynamic_string_init();
-    parse_bej_node_to_str_recursion(root, json_str, NULL, 0, map_array, map_count);
+    struct dynamic_string *patch = dynamic_string_init();
+    int ops = bej_diff_stack(prev, prev_size, cur, cur_size, map_array, map_count, &stack, patch);
+    if (ops < 0) fprintf(stderr, "BEJ diff failed: malformed snapshot or nesting deeper than %zu\n", max_depth);
+    else printf("%s\n", patch->data);
 
-    // Output JSON result
-    printf("%s\n", json_str->data);
+    free(patch->data);
+    free(patch);
+    bej_stack_free(&stack);
+    free(prev);
+    free(cur);
+    free_map(map_array, map_count);
+    return ops < 0 ? 1 : 0;
+}
+
+/**
+ * @brief Validate mode - structural check without decoding
+ * @param bej_path BEJ file to check
+ * @param map_path Map file used for the sequence range check (optional)
+ * @return 0 if valid, 1 otherwise
+ */
+static int run_validate(const char *bej_path, const char *map_path) {
+    size_t size;
+    unsigned char *buf = read_file(bej_path, &size);
+    if (!buf) return 1;
+
+    struct bej_validate_limits limits = { 0, UINT64_MAX };
+    if (map_path) {
+        size_t map_count;
+        struct field_map *map_array = load_map(map_path, &map_count);
+        if (!map_array) { fprintf(stderr, "Failed to load map\n"); free(buf); return 1; }
+        limits.max_sequence = bej_map_max_sequence(map_array, map_count);
+        free_map(map_array, map_count);
+    }
+
+    struct bej_validate_error err;
+    enum bej_validate_status status = bej_validate(buf, size, &limits, &err);
+    if (status == BEJ_VALID) printf("valid\n");
+    else printf("invalid at offset %zu (depth %zu): %s\n", err.offset, err.depth, bej_validate_strerror(status));
 
-    // Cleanup
-    free_bej_node(root);
-    free(json_str->data);
-    free(json_str);
     free(buf);
+    return status == BEJ_VALID ? 0 : 1;
+}
+
+/**
+ * @brief Extract mode - one typed column per field path across many files
+ * @param path_list Comma-separated field paths
+ * @param binary Write the binary columnar layout instead of CSV
+ * @param files BEJ files, one row each
+ * @param file_count Number of BEJ files
+ * @param map_path Map file shared by all files
+ * @return 0 on success, 1 on error
+ */
+static int run_extract(const char *path_list, bool binary, char **files, int file_count, const char *map_path) {
+    char *list = malloc(strlen(path_list) + 1);
+    if (!list) { perror("Memory allocation failed"); return 1; }
+    strcpy(list, path_list);
+
+    const char *paths[BEJ_EXTRACT_MAX_COLUMNS];
+    size_t path_count = 0;
+    char *p = list;
+    while (p && path_count < BEJ_EXTRACT_MAX_COLUMNS) {
+        char *comma = strchr(p, ',');
+        if (comma) *comma = '\0';
+        paths[path_count++] = p;
+        p = comma ? comma + 1 : NULL;
+    }
+    if (p) {
+        fprintf(stderr, "Too many field paths: at most %d columns can be extracted\n", BEJ_EXTRACT_MAX_COLUMNS);
+        free(list);
+        return 1;
+    }
+
+    size_t map_count;
+    struct field_map *map_array = load_map(map_path, &map_count);
+    if (!map_array) { fprintf(stderr, "Failed to load map\n"); free(list); return 1; }
+
+    struct bej_extractor *ex = bej_extractor_create(paths, path_count, map_array, map_count);
+    if (!ex) {
+        fprintf(stderr, "Cannot resolve field paths: %s\n", path_list);
+        free_map(map_array, map_count);
+        free(list);
+        return 1;
+    }
+
+    int rc = 0;
+    for (int i = 0; i < file_count; i++) {
+        size_t size;
+        unsigned char *buf = read_file(files[i], &size);
+        // A failed input still gets a row of nulls so rows keep the file order
+        if (!buf || bej_extract_document(ex, buf, size) < 0) {
+            fprintf(stderr, "%s: %s, row %d left empty\n", files[i], buf ? "malformed BEJ" : "unreadable", i + 1);
+            bej_extract_null_row(ex);
+            rc = 1;
+        }
+        free(buf);
+    }
+
+    struct dynamic_string *out = dynamic_string_init();
+    if (binary) bej_extractor_write_binary(ex, out);
+    else bej_extractor_write_csv(ex, out);
+    fwrite(out->data, 1, out->length, stdout);
+
+    free(out->data);
+    free(out);
+    bej_extractor_free(ex);
     free_map(map_array, map_count);
+    free(list);
+    return rc;
+}
+
+/** Settings shared by every file of a conversion run */
+struct convert_options {
+    struct field_map *map;       /**< Field map */
+    size_t map_count;            /**< Number of entries in field map */
+    struct bej_cache *cache;     /**< Conversion cache (optional) */
+    uint64_t dict_id;            /**< Dictionary identifier used as part of the cache key */
+    size_t max_depth;            /**< Maximum Set/Array nesting */
+    bool strict;                 /**< Reject sequences beyond the field map */
+    enum bej_output_format format; /**< Output format */
+    unsigned flags;              /**< BEJ_OUTPUT_* flags */
+    struct bej_context *ctx;     /**< Decoder context reused for every file */
+};
+
+/**
+ * @brief Write one converted document to stdout
+ * @param opts Conversion settings
+ * @param data Rendered output
+ * @param len Length of rendered output
+ */
+static void emit_output(const struct convert_options *opts, const char *data, size_t len) {
+    fwrite(data, 1, len, stdout);
+    // Binary formats are self-delimiting; only JSON documents get a line break
+    if (opts->format == BEJ_OUTPUT_JSON) fputc('\n', stdout);
+}
+
+/** Cache profile for the selected output format and flags */
+static uint32_t output_profile(const struct convert_options *opts) {
+    return (uint32_t)opts->format | ((uint32_t)opts->flags << 8);
+}
 
+/**
+ * @brief Convert one BEJ document and print it in the selected output format
+ * @param path BEJ file path, used in messages
+ * @param buf BEJ bytes
+ * @param size Length of BEJ bytes
+ * @param opts Conversion settings
+ * @return 0 on success, 1 on error
+ */
+static int convert_buffer(const char *path, unsigned char *buf, size_t size, struct convert_options *opts) {
+    // Byte-identical inputs are answered without decoding
+    size_t cached_len = 0;
+    const char *cached = opts->cache
+        ? bej_cache_lookup(opts->cache, buf, size, opts->dict_id, output_profile(opts), &cached_len)
+        : NULL;
+    if (cached) {
+        emit_output(opts, cached, cached_len);
+        return 0;
+    }
+
+    // Reject malformed payloads before spending anything on decoding; members
+    // missing from the map are only an error in strict mode (else field_N)
+    struct bej_validate_limits limits = {
+        opts->max_depth, opts->strict ? bej_map_max_sequence(opts->map, opts->map_count) : UINT64_MAX
+    };
+    struct bej_validate_error err;
+    if (bej_validate(buf, size, &limits, &err) != BEJ_VALID) {
+        fprintf(stderr, "%s: invalid BEJ at offset %zu: %s\n", path, err.offset, bej_validate_strerror(err.status));
+        return 1;
+    }
+
+    // Parse BEJ and convert; nodes and output live in the context
+    enum bej_context_status status = bej_context_convert(opts->ctx, buf, size, opts->format, opts->flags,
+                                                         opts->map, opts->map_count);
+    if (status != BEJ_CONTEXT_OK) {
+        fprintf(stderr, "%s: %s\n", path, bej_context_strerror(status));
+        return 1;
+    }
+
+    // Output result
+    struct dynamic_string *out = &opts->ctx->out;
+    emit_output(opts, out->data, out->length);
+    if (opts->cache)
+        bej_cache_insert(opts->cache, buf, size, opts->dict_id, output_profile(opts), out->data, out->length);
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Convert one BEJ file and print it in the selected output format
+ * @param path BEJ file path
+ * @param opts Conversion settings
+ * @return 0 on success, 1 on error
+ */
+static int convert_file(const char *path, struct convert_options *opts) {
+    // Read BEJ file into the context's reusable input buffer
+    size_t size;
+    unsigned char *buf = read_file_scratch(path, opts->ctx, &size);
+    if (!buf) return 1;
+    return convert_buffer(path, buf, size, opts);
+}
+
+/**
+ * @brief Convert many files, reading ahead while earlier ones are decoded
+ * @param paths BEJ file paths
+ * @param count Number of files
+ * @param depth Files read ahead of the decoder
+ * @param opts Conversion settings
+ * @return 0 on success, 1 if any file failed
+ */
+static int convert_batch(char **paths, size_t count, size_t depth, struct convert_options *opts) {
+    struct bej_ingest *in = bej_ingest_open(paths, count, depth, 0);
+    if (!in) {
+        // Without reader threads the files are simply read one by one
+        int rc = 0;
+        for (size_t i = 0; i < count; i++) rc |= convert_file(paths[i], opts);
+        return rc;
+    }
+
+    int rc = 0;
+    struct bej_ingest_buffer buf;
+    while (bej_ingest_next(in, &buf)) {
+        if (buf.error) {
+            fprintf(stderr, "Cannot read BEJ file %s: %s\n", buf.path, strerror(buf.error));
+            rc = 1;
+        } else {
+            rc |= convert_buffer(buf.path, buf.data, buf.size, opts);
+        }
+        bej_ingest_release(in, &buf);
+    }
+    bej_ingest_close(in);
+    return rc;
+}
+
+/** Dictionary selected by a record's schema id in stream mode */
+struct stream_schema {
+    uint32_t id;                 /**< Schema id from the record framing */
+    struct field_map *map;       /**< Field map */
+    size_t map_count;            /**< Number of entries in field map */
+    uint64_t dict_id;            /**< Cache key component for this map */
+};
+
+/** Maximum number of --schema options */
+#define MAX_STREAM_SCHEMAS 64
+
+/**
+ * @brief Stream mode - one NDJSON line per record of a multi-record input
+ * @param input Input file, or "-" for stdin
+ * @param framing Record delimiting
+ * @param max_record Largest accepted record in bytes
+ * @param schemas Dictionaries selected by schema id
+ * @param schema_count Number of schemas
+ * @param opts Conversion settings; opts->map is used for records without a schema id
+ * @return 0 if every record converted, 1 otherwise
+ */
+static int run_stream(const char *input, enum bej_stream_framing framing, size_t max_record,
+                      struct stream_schema *schemas, size_t schema_count, struct convert_options *opts) {
+    FILE *f = strcmp(input, "-") == 0 ? stdin : fopen(input, "rb");
+    if (!f) { perror("Cannot open BEJ stream"); return 1; }
+
+    struct bej_stream stream;
+    bej_stream_init(&stream, f, framing, max_record);
+
+    struct field_map *default_map = opts->map;
+    size_t default_count = opts->map_count;
+    uint64_t default_dict = opts->dict_id;
+
+    int rc = 0;
+    char name[64];
+    struct bej_stream_record rec;
+    enum bej_stream_status status;
+    while ((status = bej_stream_next(&stream, &rec)) != BEJ_STREAM_END) {
+        if (status == BEJ_STREAM_TOO_LARGE) {
+            fprintf(stderr, "record at offset %" PRIu64 ": %s, skipped\n", rec.offset, bej_stream_strerror(status));
+            rc = 1;
+            continue;
+        }
+        if (status != BEJ_STREAM_RECORD) {
+            fprintf(stderr, "record at offset %" PRIu64 ": %s\n", rec.offset, bej_stream_strerror(status));
+            rc = 1;
+            break;
+        }
+        snprintf(name, sizeof(name), "record %" PRIu64, stream.records);
+
+        opts->map = default_map;
+        opts->map_count = default_count;
+        opts->dict_id = default_dict;
+        if (rec.has_schema) {
+            struct stream_schema *schema = NULL;
+            for (size_t i = 0; i < schema_count && !schema; i++)
+                if (schemas[i].id == rec.schema_id) schema = &schemas[i];
+            if (!schema) {
+                fprintf(stderr, "%s: unknown schema id %" PRIu32 "\n", name, rec.schema_id);
+                rc = 1;
+                continue;
+            }
+            opts->map = schema->map;
+            opts->map_count = schema->map_count;
+            opts->dict_id = schema->dict_id;
+        }
+        rc |= convert_buffer(name, rec.data, rec.size, opts);
+    }
+
+    opts->map = default_map;
+    opts->map_count = default_count;
+    opts->dict_id = default_dict;
+    bej_stream_free(&stream);
+    if (f != stdin) fclose(f);
+    return rc;
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--cache <entries>] [--max-depth <n>] [--format json|cbor|msgpack] [--int-keys] [--strict]\n"
+                    "          [--max-nodes <n>] [--max-string <bytes>] [--max-output <bytes>] [--read-ahead <n>]\n"
+                    "          <bej_file> [<bej_file>...] <map_file>\n", prog);
+    fprintf(stderr, "       %s [options] --stream concat|length|length-schema [--max-record <bytes>]\n"
+                    "          [--schema <id>=<map_file>]... <bej_stream|-> <map_file>\n", prog);
+    fprintf(stderr, "       %s --diff [--max-depth <n>] <prev_bej> <cur_bej> <map_file>\n", prog);
+    fprintf(stderr, "       %s --validate <bej_file> [<map_file>]\n", prog);
+    fprintf(stderr, "       %s --extract <path>[,<path>...] [--columns csv|bin] <bej_file>... <map_file>\n", prog);
+    fprintf(stderr, "\n--diff paths start at the top-level member (/Sensor/Status/Health); --extract\n"
+                    "paths leave out a lone top-level Set (Status/Health).\n");
+}
+
+/**
+ * @brief Main function - converts BEJ files to JSON using map file
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments: [program] [options] <bej_file>... <map_file>
+ *             or [program] --diff [--max-depth <n>] <prev_bej> <cur_bej> <map_file>
+ *             or [program] --validate <bej_file> [<map_file>]
+ *             or [program] --extract <paths> [--columns csv|bin] <bej_file>... <map_file>
+ * @return 0 on success, 1 on error
+ *
+ * @usage ./bej_to_json input.bej dictionary.map
+ */
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "--diff") == 0) {
+        int files = 2;
+        size_t max_depth = BEJ_DEFAULT_MAX_DEPTH;
+        if (argc >= 4 && strcmp(argv[2], "--max-depth") == 0) {
+            max_depth = strtoul(argv[3], NULL, 10);
+            files = 4;
+        }
+        if (argc < files + 3 || max_depth == 0 || max_depth > BEJ_VALIDATE_MAX_DEPTH) {
+            fprintf(stderr, "Usage: %s --diff [--max-depth <n>] <prev_bej> <cur_bej> <map_file>\n", argv[0]);
+            return 1;
+        }
+        return run_diff(argv[files], argv[files + 1], argv[files + 2], max_depth);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--validate") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "Usage: %s --validate <bej_file> [<map_file>]\n", argv[0]);
+            return 1;
+        }
+        return run_validate(argv[2], argc >= 4 ? argv[3] : NULL);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "--extract") == 0) {
+        int files = 3;
+        bool binary = false;
+        if (argc >= 5 && strcmp(argv[3], "--columns") == 0) {
+            binary = strcmp(argv[4], "bin") == 0;
+            if (!binary && strcmp(argv[4], "csv") != 0) { print_usage(argv[0]); return 1; }
+            files = 5;
+        }
+        if (argc - files < 2) { print_usage(argv[0]); return 1; }
+        return run_extract(argv[2], binary, argv + files, argc - files - 1, argv[argc - 1]);
+    }
+
+    size_t cache_entries = 0;
+    size_t max_depth = BEJ_DEFAULT_MAX_DEPTH;
+    enum bej_output_format format = BEJ_OUTPUT_JSON;
+    unsigned flags = 0;
+    struct bej_budget budget = {0};
+    size_t read_ahead = BEJ_INGEST_DEFAULT_DEPTH;
+    bool stream = false;
+    enum bej_stream_framing framing = BEJ_FRAMING_CONCAT;
+    size_t max_record = BEJ_STREAM_DEFAULT_MAX_RECORD;
+    struct stream_schema schemas[MAX_STREAM_SCHEMAS];
+    const char *schema_paths[MAX_STREAM_SCHEMAS];
+    size_t schema_count = 0;
+    bool strict = false;
+    int first = 1;
+    while (first < argc && strncmp(argv[first], "--", 2) == 0) {
+        if (strcmp(argv[first], "--cache") == 0 && first + 1 < argc) {
+            cache_entries = strtoul(argv[first + 1], NULL, 10);
+            first += 2;
+        } else if (strcmp(argv[first], "--max-depth") == 0 && first + 1 < argc) {
+            max_depth = strtoul(argv[first + 1], NULL, 10);
+            first += 2;
+        } else if (strcmp(argv[first], "--format") == 0 && first + 1 < argc) {
+            const char *name = argv[first + 1];
+            if (strcmp(name, "json") == 0) format = BEJ_OUTPUT_JSON;
+            else if (strcmp(name, "cbor") == 0) format = BEJ_OUTPUT_CBOR;
+            else if (strcmp(name, "msgpack") == 0) format = BEJ_OUTPUT_MSGPACK;
+            else { print_usage(argv[0]); return 1; }
+            first += 2;
+        } else if (strcmp(argv[first], "--max-nodes") == 0 && first + 1 < argc) {
+            budget.max_nodes = strtoul(argv[first + 1], NULL, 10);
+            first += 2;
+        } else if (strcmp(argv[first], "--max-string") == 0 && first + 1 < argc) {
+            budget.max_string = strtoul(argv[first + 1], NULL, 10);
+            first += 2;
+        } else if (strcmp(argv[first], "--max-output") == 0 && first + 1 < argc) {
+            budget.max_output = strtoul(argv[first + 1], NULL, 10);
+            first += 2;
+        } else if (strcmp(argv[first], "--read-ahead") == 0 && first + 1 < argc) {
+            read_ahead = strtoul(argv[first + 1], NULL, 10);
+            first += 2;
+        } else if (strcmp(argv[first], "--stream") == 0 && first + 1 < argc) {
+            const char *name = argv[first + 1];
+            if (strcmp(name, "concat") == 0) framing = BEJ_FRAMING_CONCAT;
+            else if (strcmp(name, "length") == 0) framing = BEJ_FRAMING_LENGTH;
+            else if (strcmp(name, "length-schema") == 0) framing = BEJ_FRAMING_LENGTH_SCHEMA;
+            else { print_usage(argv[0]); return 1; }
+            stream = true;
+            first += 2;
+        } else if (strcmp(argv[first], "--max-record") == 0 && first + 1 < argc) {
+            max_record = strtoul(argv[first + 1], NULL, 10);
+            first += 2;
+        } else if (strcmp(argv[first], "--schema") == 0 && first + 1 < argc) {
+            const char *eq = strchr(argv[first + 1], '=');
+            if (!eq || schema_count == MAX_STREAM_SCHEMAS) { print_usage(argv[0]); return 1; }
+            schemas[schema_count].id = (uint32_t)strtoul(argv[first + 1], NULL, 10);
+            schema_paths[schema_count++] = eq + 1;
+            first += 2;
+        } else if (strcmp(argv[first], "--int-keys") == 0) {
+            flags |= BEJ_OUTPUT_INT_KEYS;
+            first++;
+        } else if (strcmp(argv[first], "--strict") == 0) {
+            strict = true;
+            first++;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (argc - first < 2 || (stream && argc - first != 2) || max_depth == 0 || max_depth > BEJ_VALIDATE_MAX_DEPTH) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    struct convert_options opts = {0};
+
+    // Load field map
+    const char *map_path = argv[argc - 1];
+    opts.map = load_map(map_path, &opts.map_count);
+    if (!opts.map) { fprintf(stderr, "Failed to load map\n"); return 1; }
+
+    opts.max_depth = max_depth;
+    opts.strict = strict;
+    opts.format = format;
+    opts.flags = flags;
+    opts.ctx = bej_context_create(max_depth, &budget);
+    if (!opts.ctx) { perror("Memory allocation failed"); free_map(opts.map, opts.map_count); return 1; }
+    opts.cache = cache_entries ? bej_cache_create(cache_entries, 0) : NULL;
+    opts.dict_id = bej_hash64(map_path, strlen(map_path), 0);
+
+    int rc = 0;
+    size_t file_count = (size_t)(argc - 1 - first);
+    if (stream) {
+        // One compact JSON document per line
+        if (opts.format == BEJ_OUTPUT_JSON) opts.flags |= BEJ_OUTPUT_COMPACT;
+        size_t loaded = 0;
+        for (; loaded < schema_count; loaded++) {
+            schemas[loaded].map = load_map(schema_paths[loaded], &schemas[loaded].map_count);
+            if (!schemas[loaded].map) { fprintf(stderr, "Failed to load map %s\n", schema_paths[loaded]); rc = 1; break; }
+            schemas[loaded].dict_id = bej_hash64(schema_paths[loaded], strlen(schema_paths[loaded]), 0);
+        }
+        if (rc == 0) rc = run_stream(argv[first], framing, max_record, schemas, schema_count, &opts);
+        for (size_t i = 0; i < loaded; i++) free_map(schemas[i].map, schemas[i].map_count);
+    } else if (file_count > 1 && read_ahead > 0) {
+        rc = convert_batch(argv + first, file_count, read_ahead, &opts);
+    } else {
+        for (int i = first; i < argc - 1; i++)
+            rc |= convert_file(argv[i], &opts);
+    }
+
+    if (opts.cache) {
+        struct bej_cache_stats stats;
+        bej_cache_get_stats(opts.cache, &stats);
+        fprintf(stderr, "cache: hits=%" PRIu64 " misses=%" PRIu64 " evictions=%" PRIu64 " entries=%zu bytes=%zu\n",
+                stats.hits, stats.misses, stats.evictions, stats.entries, stats.bytes);
+        bej_cache_free(opts.cache);
+    }
+
+    bej_context_free(opts.ctx);
+    free_map(opts.map, opts.map_count);
+    return rc;
+}
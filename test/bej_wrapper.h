@@ -7,6 +7,15 @@ extern "C" {
 
 #include "../include/bej_parser.h"
 #include "../include/json_writer.h"
+#include "../include/bej_diff.h"
+#include "../include/bej_cache.h"
+#include "../include/bej_validate.h"
+#include "../include/binary_writer.h"
+#include "../include/bej_extract.h"
+#include "../include/bej_context.h"
+#include "../include/bej_ingest.h"
+#include "../include/bej_stream.h"
+#include "../include/bej_strpool.h"
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "bej_wrapper.h"
+#include <string.h>
+
+class BejCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        cache = bej_cache_create(2, 0);
+        ASSERT_TRUE(cache != nullptr);
+    }
+
+    void TearDown() override {
+        bej_cache_free(cache);
+    }
+
+    struct bej_cache* cache;
+};
+
+TEST_F(BejCacheTest, HashIsDeterministic) {
+    const char data[] = "The quick brown fox jumps over the lazy dog";
+    EXPECT_EQ(bej_hash64(data, sizeof(data), 0), bej_hash64(data, sizeof(data), 0));
+    EXPECT_NE(bej_hash64(data, sizeof(data), 0), bej_hash64(data, sizeof(data), 1));
+    EXPECT_NE(bej_hash64(data, sizeof(data), 0), bej_hash64(data, sizeof(data) - 1, 0));
+}
+
+TEST_F(BejCacheTest, MissThenHit) {
+    unsigned char bej[] = {0x01, 0x00, 0x01, 0x01, 0x06, 0x01, 0x02, 0x03, 0x01, 0x01, 0x2A};
+    const char json[] = "{\"Reading\": 42}";
+
+    EXPECT_EQ(bej_cache_lookup(cache, bej, sizeof(bej), 7, 0, nullptr), nullptr);
+    EXPECT_EQ(bej_cache_insert(cache, bej, sizeof(bej), 7, 0, json, strlen(json)), 0);
+
+    size_t len = 0;
+    const char* hit = bej_cache_lookup(cache, bej, sizeof(bej), 7, 0, &len);
+    ASSERT_TRUE(hit != nullptr);
+    EXPECT_STREQ(hit, json);
+    EXPECT_EQ(len, strlen(json));
+
+    struct bej_cache_stats stats;
+    bej_cache_get_stats(cache, &stats);
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.entries, 1u);
+}
+
+TEST_F(BejCacheTest, KeyIncludesDictionaryAndProfile) {
+    unsigned char bej[] = {0x01, 0x02, 0x03, 0x01, 0x01, 0x2A};
+    bej_cache_insert(cache, bej, sizeof(bej), 1, 0, "a", 1);
+
+    EXPECT_EQ(bej_cache_lookup(cache, bej, sizeof(bej), 2, 0, nullptr), nullptr);
+    EXPECT_EQ(bej_cache_lookup(cache, bej, sizeof(bej), 1, 1, nullptr), nullptr);
+    EXPECT_TRUE(bej_cache_lookup(cache, bej, sizeof(bej), 1, 0, nullptr) != nullptr);
+}
+
+TEST_F(BejCacheTest, EvictsLeastRecentlyUsed) {
+    unsigned char a[] = {0x01};
+    unsigned char b[] = {0x02};
+    unsigned char c[] = {0x03};
+
+    bej_cache_insert(cache, a, 1, 0, 0, "a", 1);
+    bej_cache_insert(cache, b, 1, 0, 0, "b", 1);
+    bej_cache_lookup(cache, a, 1, 0, 0, nullptr);
+    bej_cache_insert(cache, c, 1, 0, 0, "c", 1);
+
+    EXPECT_TRUE(bej_cache_lookup(cache, a, 1, 0, 0, nullptr) != nullptr);
+    EXPECT_EQ(bej_cache_lookup(cache, b, 1, 0, 0, nullptr), nullptr);
+    EXPECT_TRUE(bej_cache_lookup(cache, c, 1, 0, 0, nullptr) != nullptr);
+
+    struct bej_cache_stats stats;
+    bej_cache_get_stats(cache, &stats);
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.entries, 2u);
+}
+
+TEST_F(BejCacheTest, ByteBound) {
+    struct bej_cache* small = bej_cache_create(16, 8);
+    unsigned char bej[] = {0x01, 0x02, 0x03, 0x04};
+
+    EXPECT_EQ(bej_cache_insert(small, bej, sizeof(bej), 0, 0, "too long", 8), -1);
+    EXPECT_EQ(bej_cache_insert(small, bej, sizeof(bej), 0, 0, "ok", 2), 0);
+    EXPECT_EQ(bej_cache_insert(small, bej, 2, 0, 0, "ok", 2), 0);
+
+    struct bej_cache_stats stats;
+    bej_cache_get_stats(small, &stats);
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_LE(stats.bytes, 8u);
+    bej_cache_free(small);
+}
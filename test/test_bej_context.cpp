@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include "test_fixtures.h"
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+class BejContextTest : public SensorMapTest {};
+
+TEST_F(BejContextTest, MatchesHeapDecoder) {
+    struct bej_node* heap = parse_sflv_init(sensor_doc, sizeof(sensor_doc), NULL);
+    struct dynamic_string* expected = dynamic_string_init();
+    parse_bej_node_to_str_recursion(heap, expected, NULL, 0, map, sensor_map_count);
+
+    struct bej_context* ctx = bej_context_create(BEJ_DEFAULT_MAX_DEPTH, NULL);
+    ASSERT_TRUE(ctx != nullptr);
+    EXPECT_EQ(bej_context_convert(ctx, sensor_doc, sizeof(sensor_doc), BEJ_OUTPUT_JSON, 0, map, sensor_map_count), BEJ_CONTEXT_OK);
+    EXPECT_STREQ(ctx->out.data, expected->data);
+    EXPECT_EQ(ctx->nodes, 6u);
+
+    bej_context_free(ctx);
+    free_bej_node(heap);
+    free(expected->data);
+    free(expected);
+}
+
+TEST_F(BejContextTest, NoGrowthAfterWarmup) {
+    struct bej_context* ctx = bej_context_create(BEJ_DEFAULT_MAX_DEPTH, NULL);
+    ASSERT_TRUE(ctx != nullptr);
+
+    unsigned char* input = bej_context_scratch(ctx, sizeof(sensor_doc));
+    memcpy(input, sensor_doc, sizeof(sensor_doc));
+    ASSERT_EQ(bej_context_convert(ctx, input, sizeof(sensor_doc), BEJ_OUTPUT_JSON, 0, map, sensor_map_count), BEJ_CONTEXT_OK);
+    std::string first(ctx->out.data, ctx->out.length);
+    size_t blocks = ctx->arena.blocks;
+    char* out_data = ctx->out.data;
+
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_EQ(bej_context_scratch(ctx, sizeof(sensor_doc)), input);
+        ASSERT_EQ(bej_context_convert(ctx, input, sizeof(sensor_doc), BEJ_OUTPUT_JSON, 0, map, sensor_map_count), BEJ_CONTEXT_OK);
+    }
+    EXPECT_EQ(ctx->arena.blocks, blocks);
+    EXPECT_EQ(ctx->out.data, out_data);
+    EXPECT_EQ(std::string(ctx->out.data, ctx->out.length), first);
+
+    bej_context_free(ctx);
+}
+
+TEST_F(BejContextTest, LargeDocumentReusesBlocks) {
+    // An Array of 10000 one-byte integers needs more than one arena block
+    const size_t n = 10000;
+    std::vector<unsigned char> bej = {0x01, 0x00, 0x02, 0x02, 0x00, 0x00};
+    for (size_t i = 0; i < n; i++) {
+        unsigned char member[] = {0x01, 0x00, 0x03, 0x01, 0x01, (unsigned char)i};
+        bej.insert(bej.end(), member, member + sizeof(member));
+    }
+    bej[4] = (unsigned char)((n * 6) & 0xFF);
+    bej[5] = (unsigned char)((n * 6) >> 8);
+
+    struct bej_context* ctx = bej_context_create(BEJ_DEFAULT_MAX_DEPTH, NULL);
+    ASSERT_TRUE(ctx != nullptr);
+    struct bej_node* root = bej_context_parse(ctx, bej.data(), bej.size());
+    ASSERT_TRUE(root != nullptr);
+    ASSERT_EQ(root->children_count, 1u);
+    EXPECT_EQ(root->children[0]->children_count, n);
+    EXPECT_EQ(*(int8_t*)root->children[0]->children[7]->value, 7);
+    size_t blocks = ctx->arena.blocks;
+    EXPECT_GT(blocks, 1u);
+
+    root = bej_context_parse(ctx, bej.data(), bej.size());
+    EXPECT_EQ(root->children[0]->children_count, n);
+    EXPECT_EQ(ctx->arena.blocks, blocks);
+
+    bej_context_free(ctx);
+}
+
+TEST_F(BejContextTest, NodeBudget) {
+    struct bej_budget budget = {};
+    budget.max_nodes = 4;
+    struct bej_context* ctx = bej_context_create(BEJ_DEFAULT_MAX_DEPTH, &budget);
+    ASSERT_TRUE(ctx != nullptr);
+
+    EXPECT_EQ(bej_context_convert(ctx, sensor_doc, sizeof(sensor_doc), BEJ_OUTPUT_JSON, 0, map, sensor_map_count), BEJ_CONTEXT_NODE_BUDGET);
+    EXPECT_EQ(ctx->nodes, 4u);
+
+    // The next document starts with a fresh count
+    unsigned char small[] = {0x01, 0x02, 0x03, 0x01, 0x01, 0x05};
+    EXPECT_EQ(bej_context_convert(ctx, small, sizeof(small), BEJ_OUTPUT_JSON, 0, map, sensor_map_count), BEJ_CONTEXT_OK);
+    EXPECT_STREQ(ctx->out.data, "{\n  \"Reading\": 5\n}");
+
+    bej_context_free(ctx);
+}
+
+TEST_F(BejContextTest, StringBudget) {
+    struct bej_budget budget = {};
+    budget.max_string = 3;
+    struct bej_context* ctx = bej_context_create(BEJ_DEFAULT_MAX_DEPTH, &budget);
+    ASSERT_TRUE(ctx != nullptr);
+
+    unsigned char ok[] = {0x01, 0x04, 0x05, 0x01, 0x03, 'a', 'b', 0x00};
+    EXPECT_EQ(bej_context_convert(ctx, ok, sizeof(ok), BEJ_OUTPUT_JSON, 0, map, sensor_map_count), BEJ_CONTEXT_OK);
+
+    unsigned char big[] = {0x01, 0x04, 0x05, 0x01, 0x05, 'a', 'b', 'c', 'd', 0x00};
+    EXPECT_EQ(bej_context_convert(ctx, big, sizeof(big), BEJ_OUTPUT_JSON, 0, map, sensor_map_count), BEJ_CONTEXT_STRING_BUDGET);
+
+    bej_context_free(ctx);
+}
+
+TEST_F(BejContextTest, OutputBudget) {
+    struct bej_budget budget = {};
+    budget.max_output = 16;
+    struct bej_context* ctx = bej_context_create(BEJ_DEFAULT_MAX_DEPTH, &budget);
+    ASSERT_TRUE(ctx != nullptr);
+
+    EXPECT_EQ(bej_context_convert(ctx, sensor_doc, sizeof(sensor_doc), BEJ_OUTPUT_JSON, 0, map, sensor_map_count), BEJ_CONTEXT_OUTPUT_BUDGET);
+    EXPECT_LE(ctx->out.length, 16u);
+
+    budget.max_output = 0;
+    ctx->budget = budget;
+    EXPECT_EQ(bej_context_convert(ctx, sensor_doc, sizeof(sensor_doc), BEJ_OUTPUT_JSON, 0, map, sensor_map_count), BEJ_CONTEXT_OK);
+
+    bej_context_free(ctx);
+}
+
+TEST_F(BejContextTest, DepthLimit) {
+    unsigned char nested[] = {0x01, 0x00, 0x01, 0x01, 0x05, 0x01, 0x06, 0x01, 0x01, 0x00};
+    struct bej_context* ctx = bej_context_create(1, NULL);
+    ASSERT_TRUE(ctx != nullptr);
+    EXPECT_EQ(bej_context_convert(ctx, nested, sizeof(nested), BEJ_OUTPUT_JSON, 0, map, sensor_map_count), BEJ_CONTEXT_TOO_DEEP);
+    bej_context_free(ctx);
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include "test_fixtures.h"
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+class BejDiffTest : public SensorMapTest {
+protected:
+    void SetUp() override {
+        SensorMapTest::SetUp();
+        patch = dynamic_string_init();
+    }
+
+    void TearDown() override {
+        free(patch->data);
+        free(patch);
+        SensorMapTest::TearDown();
+    }
+
+    struct dynamic_string* patch;
+};
+
+TEST_F(BejDiffTest, IdenticalSnapshots) {
+    unsigned char cur[sizeof(sensor_doc)];
+    memcpy(cur, sensor_doc, sizeof(sensor_doc));
+
+    int ops = bej_diff(sensor_doc, sizeof(sensor_doc), cur, sizeof(cur), map, sensor_map_count, patch);
+    EXPECT_EQ(ops, 0);
+    EXPECT_STREQ(patch->data, "[]");
+}
+
+TEST_F(BejDiffTest, ChangedLeaf) {
+    unsigned char cur[sizeof(sensor_doc)];
+    memcpy(cur, sensor_doc, sizeof(sensor_doc));
+    cur[10] = 0x2B;
+
+    int ops = bej_diff(sensor_doc, sizeof(sensor_doc), cur, sizeof(cur), map, sensor_map_count, patch);
+    EXPECT_EQ(ops, 1);
+    EXPECT_STREQ(patch->data,
+                 "[\n  {\"op\": \"replace\", \"path\": \"/Sensor/Reading\", \"value\": 43}\n]");
+}
+
+TEST_F(BejDiffTest, ChangedNestedLeaf) {
+    unsigned char cur[sizeof(sensor_doc)];
+    memcpy(cur, sensor_doc, sizeof(sensor_doc));
+    cur[28] = 0x02;
+
+    int ops = bej_diff(sensor_doc, sizeof(sensor_doc), cur, sizeof(cur), map, sensor_map_count, patch);
+    EXPECT_EQ(ops, 1);
+    EXPECT_TRUE(strstr(patch->data, "\"path\": \"/Sensor/Status/Health\", \"value\": 2") != nullptr);
+}
+
+TEST_F(BejDiffTest, RemovedAndAddedMembers) {
+    // Sensor { Reading: 42, Status { Health: 1 } }
+    unsigned char cur[] = {
+        0x01, 0x00, 0x01, 0x01, 0x12,
+        0x01, 0x02, 0x03, 0x01, 0x01, 0x2A,
+        0x01, 0x06, 0x01, 0x01, 0x07, 0x01, 0x08, 0x04, 0x01, 0x02, 0x01, 0x01
+    };
+
+    int ops = bej_diff(sensor_doc, sizeof(sensor_doc), cur, sizeof(cur), map, sensor_map_count, patch);
+    EXPECT_EQ(ops, 1);
+    EXPECT_TRUE(strstr(patch->data, "{\"op\": \"remove\", \"path\": \"/Sensor/Id\"}") != nullptr);
+
+    free(patch->data);
+    free(patch);
+    patch = dynamic_string_init();
+
+    ops = bej_diff(cur, sizeof(cur), sensor_doc, sizeof(sensor_doc), map, sensor_map_count, patch);
+    EXPECT_EQ(ops, 1);
+    EXPECT_TRUE(strstr(patch->data, "{\"op\": \"add\", \"path\": \"/Sensor/Id\", \"value\": \"A\"}") != nullptr);
+}
+
+TEST_F(BejDiffTest, TruncatedSnapshot) {
+    unsigned char cur[] = {0x01, 0x00, 0x01, 0x01, 0x18, 0x01, 0x02, 0x03};
+
+    int ops = bej_diff(sensor_doc, sizeof(sensor_doc), cur, sizeof(cur), map, sensor_map_count, patch);
+    EXPECT_EQ(ops, -1);
+}
+
+// levels nested Sets around one integer leaf
+static std::vector<unsigned char> nested_doc(int levels, unsigned char leaf) {
+    std::vector<unsigned char> data = {0x01, 0x02, 0x03, 0x01, 0x01, leaf};
+    for (int i = 0; i < levels; i++) {
+        std::vector<unsigned char> outer = {0x01, 0x00, 0x01, 0x02};
+        size_t len = data.size();
+        outer.push_back((unsigned char)(len & 0xFF));
+        outer.push_back((unsigned char)(len >> 8));
+        outer.insert(outer.end(), data.begin(), data.end());
+        data.swap(outer);
+    }
+    return data;
+}
+
+TEST_F(BejDiffTest, DeepNestingIsBounded) {
+    std::vector<unsigned char> prev = nested_doc(2000, 1);
+    std::vector<unsigned char> cur = nested_doc(2000, 2);
+
+    int ops = bej_diff(prev.data(), prev.size(), cur.data(), cur.size(), map, sensor_map_count, patch);
+    EXPECT_EQ(ops, -1);
+}
+
+TEST_F(BejDiffTest, NestingWithinStackDepth) {
+    std::vector<unsigned char> prev = nested_doc(100, 1);
+    std::vector<unsigned char> cur = nested_doc(100, 2);
+
+    struct bej_stack stack;
+    ASSERT_TRUE(bej_stack_init(&stack, 100));
+    int ops = bej_diff_stack(prev.data(), prev.size(), cur.data(), cur.size(), map, sensor_map_count, &stack, patch);
+    EXPECT_EQ(ops, 1);
+    EXPECT_TRUE(strstr(patch->data, "\"path\": \"/Sensor/Sensor/") != nullptr);
+    EXPECT_TRUE(strstr(patch->data, "/Reading\", \"value\": 2}") != nullptr);
+    bej_stack_free(&stack);
+
+    ASSERT_TRUE(bej_stack_init(&stack, 99));
+    free(patch->data);
+    free(patch);
+    patch = dynamic_string_init();
+    ops = bej_diff_stack(prev.data(), prev.size(), cur.data(), cur.size(), map, sensor_map_count, &stack, patch);
+    EXPECT_EQ(ops, -1);
+    bej_stack_free(&stack);
+}
+
+TEST_F(BejDiffTest, AddedSubtreeAtDepthLimit) {
+    // Sensor { Reading: 42 }
+    unsigned char prev[] = {0x01, 0x00, 0x01, 0x01, 0x06, 0x01, 0x02, 0x03, 0x01, 0x01, 0x2A};
+    // Sensor { Reading: 42, Id: "A" }
+    unsigned char scalar_only[] = {0x01, 0x00, 0x01, 0x01, 0x0C, 0x01, 0x02, 0x03, 0x01, 0x01, 0x2A,
+                                   0x01, 0x04, 0x05, 0x01, 0x01, 'A'};
+
+    // Sensor takes the only level, so an added scalar fits and Status does not
+    struct bej_stack stack;
+    ASSERT_TRUE(bej_stack_init(&stack, 1));
+    int ops = bej_diff_stack(prev, sizeof(prev), scalar_only, sizeof(scalar_only),
+                             map, sensor_map_count, &stack, patch);
+    EXPECT_EQ(ops, 1);
+    EXPECT_TRUE(strstr(patch->data, "\"path\": \"/Sensor/Id\", \"value\": \"A\"") != nullptr);
+
+    free(patch->data);
+    free(patch);
+    patch = dynamic_string_init();
+    ops = bej_diff_stack(prev, sizeof(prev), sensor_doc, sizeof(sensor_doc),
+                         map, sensor_map_count, &stack, patch);
+    EXPECT_EQ(ops, -1);
+    bej_stack_free(&stack);
+
+    free(patch->data);
+    free(patch);
+    patch = dynamic_string_init();
+    ASSERT_TRUE(bej_stack_init(&stack, 2));
+    ops = bej_diff_stack(prev, sizeof(prev), sensor_doc, sizeof(sensor_doc),
+                         map, sensor_map_count, &stack, patch);
+    EXPECT_EQ(ops, 2);
+    EXPECT_TRUE(strstr(patch->data, "\"path\": \"/Sensor/Status\", \"value\": {") != nullptr);
+    bej_stack_free(&stack);
+}
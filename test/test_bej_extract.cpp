@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "test_fixtures.h"
+#include <stdlib.h>
+#include <string.h>
+
+class BejExtractTest : public SensorMapTest {
+protected:
+    void SetUp() override {
+        SensorMapTest::SetUp();
+        const char* paths[] = {"Reading", "Status/Health", "Id"};
+        ex = bej_extractor_create(paths, 3, map, sensor_map_count);
+        ASSERT_TRUE(ex != nullptr);
+        out = dynamic_string_init();
+    }
+
+    void TearDown() override {
+        bej_extractor_free(ex);
+        free(out->data);
+        free(out);
+        SensorMapTest::TearDown();
+    }
+
+    struct bej_extractor* ex;
+    struct dynamic_string* out;
+};
+
+// Sensor { Reading: -3, Status { Health: 2 } }
+static unsigned char partial_doc[] = {
+    0x01, 0x00, 0x01, 0x01, 0x12,
+    0x01, 0x02, 0x03, 0x01, 0x01, 0xFD,
+    0x01, 0x06, 0x01, 0x01, 0x07, 0x01, 0x08, 0x04, 0x01, 0x02, 0x01, 0x02
+};
+
+TEST_F(BejExtractTest, UnknownPathFails) {
+    const char* paths[] = {"Status/Missing"};
+    EXPECT_EQ(bej_extractor_create(paths, 1, map, sensor_map_count), nullptr);
+}
+
+TEST_F(BejExtractTest, TypedColumns) {
+    ASSERT_EQ(bej_extract_document(ex, sensor_doc, sizeof(sensor_doc)), 0);
+    ASSERT_EQ(ex->rows, 1u);
+
+    EXPECT_EQ(ex->columns[0].type, BEJ_COLUMN_INT);
+    EXPECT_EQ(ex->columns[0].values[0], 42);
+    EXPECT_EQ(ex->columns[1].type, BEJ_COLUMN_ENUM);
+    EXPECT_EQ(ex->columns[1].values[0], 1);
+    EXPECT_EQ(ex->columns[2].type, BEJ_COLUMN_STRING);
+    EXPECT_EQ(ex->columns[2].str_offsets[1], 1u);
+    EXPECT_EQ(ex->columns[2].str_data->data[0], 'A');
+}
+
+TEST_F(BejExtractTest, CsvWithMissingField) {
+    ASSERT_EQ(bej_extract_document(ex, sensor_doc, sizeof(sensor_doc)), 0);
+    ASSERT_EQ(bej_extract_document(ex, partial_doc, sizeof(partial_doc)), 0);
+    EXPECT_EQ(ex->columns[2].valid[1], 0);
+
+    bej_extractor_write_csv(ex, out);
+    EXPECT_STREQ(out->data, "Reading,Status/Health,Id\n42,1,A\n-3,2,\n");
+}
+
+TEST_F(BejExtractTest, MalformedDocumentAddsNoRow) {
+    unsigned char truncated[] = {0x01, 0x00, 0x01, 0x01, 0x18, 0x01, 0x02, 0x03, 0x01, 0x05, 0x2A};
+    EXPECT_EQ(bej_extract_document(ex, truncated, sizeof(truncated)), -1);
+    EXPECT_EQ(ex->rows, 0u);
+}
+
+TEST_F(BejExtractTest, NullRowKeepsInputOrder) {
+    ASSERT_EQ(bej_extract_document(ex, sensor_doc, sizeof(sensor_doc)), 0);
+    ASSERT_EQ(bej_extract_null_row(ex), 0);
+    ASSERT_EQ(bej_extract_document(ex, partial_doc, sizeof(partial_doc)), 0);
+    EXPECT_EQ(ex->rows, 3u);
+
+    bej_extractor_write_csv(ex, out);
+    EXPECT_STREQ(out->data, "Reading,Status/Health,Id\n42,1,A\n,,\n-3,2,\n");
+}
+
+TEST_F(BejExtractTest, BinaryLayoutHeader) {
+    ASSERT_EQ(bej_extract_document(ex, sensor_doc, sizeof(sensor_doc)), 0);
+    ASSERT_EQ(bej_extract_document(ex, partial_doc, sizeof(partial_doc)), 0);
+
+    bej_extractor_write_binary(ex, out);
+    ASSERT_GE(out->length, 20u);
+    EXPECT_EQ(memcmp(out->data, "BEJCOL01", 8), 0);
+    EXPECT_EQ((unsigned char)out->data[8], 3);
+    EXPECT_EQ((unsigned char)out->data[12], 2);
+    // First column: path "Reading", INT type, two valid rows, then 42 and -3
+    EXPECT_EQ((unsigned char)out->data[20], 7);
+    EXPECT_EQ(memcmp(out->data + 22, "Reading", 7), 0);
+    EXPECT_EQ((unsigned char)out->data[29], BEJ_COLUMN_INT);
+    int64_t first, second;
+    memcpy(&first, out->data + 32, 8);
+    memcpy(&second, out->data + 40, 8);
+    EXPECT_EQ(first, 42);
+    EXPECT_EQ(second, -3);
+}
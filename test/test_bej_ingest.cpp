@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include "bej_wrapper.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <string>
+#include <vector>
+
+class BejIngestTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        for (int i = 0; i < 20; i++) {
+            std::string path = "test_ingest_" + std::to_string(i) + ".bej";
+            FILE* f = fopen(path.c_str(), "wb");
+            ASSERT_TRUE(f != nullptr);
+            // File i holds i + 1 copies of the byte i
+            std::vector<unsigned char> bytes(i + 1, (unsigned char)i);
+            fwrite(bytes.data(), 1, bytes.size(), f);
+            fclose(f);
+            names.push_back(path);
+        }
+        for (auto& n : names) paths.push_back(&n[0]);
+    }
+
+    void TearDown() override {
+        for (auto& n : names) remove(n.c_str());
+    }
+
+    std::vector<std::string> names;
+    std::vector<char*> paths;
+};
+
+TEST_F(BejIngestTest, DeliversInOrder) {
+    struct bej_ingest* in = bej_ingest_open(paths.data(), paths.size(), 3, 4);
+    ASSERT_TRUE(in != nullptr);
+
+    struct bej_ingest_buffer buf;
+    size_t seen = 0;
+    while (bej_ingest_next(in, &buf)) {
+        EXPECT_EQ(buf.index, seen);
+        EXPECT_STREQ(buf.path, paths[seen]);
+        EXPECT_EQ(buf.error, 0);
+        ASSERT_EQ(buf.size, seen + 1);
+        for (size_t i = 0; i < buf.size; i++) EXPECT_EQ(buf.data[i], (unsigned char)seen);
+        bej_ingest_release(in, &buf);
+        seen++;
+    }
+    EXPECT_EQ(seen, paths.size());
+    bej_ingest_close(in);
+}
+
+TEST_F(BejIngestTest, MissingFileReportsError) {
+    char missing[] = "test_ingest_missing.bej";
+    char* list[] = {paths[0], missing, paths[1]};
+    struct bej_ingest* in = bej_ingest_open(list, 3, 0, 0);
+    ASSERT_TRUE(in != nullptr);
+
+    struct bej_ingest_buffer buf;
+    ASSERT_TRUE(bej_ingest_next(in, &buf));
+    EXPECT_EQ(buf.error, 0);
+    bej_ingest_release(in, &buf);
+    ASSERT_TRUE(bej_ingest_next(in, &buf));
+    EXPECT_EQ(buf.error, ENOENT);
+    EXPECT_EQ(buf.size, 0u);
+    bej_ingest_release(in, &buf);
+    ASSERT_TRUE(bej_ingest_next(in, &buf));
+    EXPECT_EQ(buf.size, 2u);
+    bej_ingest_release(in, &buf);
+    EXPECT_FALSE(bej_ingest_next(in, &buf));
+    bej_ingest_close(in);
+}
+
+TEST_F(BejIngestTest, CloseWhileReadingAhead) {
+    struct bej_ingest* in = bej_ingest_open(paths.data(), paths.size(), 4, 2);
+    ASSERT_TRUE(in != nullptr);
+    struct bej_ingest_buffer buf;
+    ASSERT_TRUE(bej_ingest_next(in, &buf));
+    bej_ingest_release(in, &buf);
+    bej_ingest_close(in);
+}
@@ -2,6 +2,7 @@
 #include "bej_wrapper.h"
 #include <stdlib.h>
 #include <string.h>
+#include <vector>
 
 class BejParserTest : public ::testing::Test {
 protected:
@@ -39,6 +40,55 @@ TEST_F(BejParserTest, ReadVarintMultiByte) {
     EXPECT_EQ(ptr, data + 2);
 }
 
+// nnint tests
+TEST_F(BejParserTest, ReadNnintSingleByte) {
+    unsigned char data[] = {0x01, 0x2A};
+    unsigned char* ptr = data;
+    uint64_t value = 0;
+
+    EXPECT_TRUE(read_nnint(&ptr, data + sizeof(data), &value));
+    EXPECT_EQ(value, 42u);
+    EXPECT_EQ(ptr, data + 2);
+}
+
+TEST_F(BejParserTest, ReadNnintMultiByte) {
+    // Enough trailing bytes for the 64-bit load path, which must mask them off
+    unsigned char data[] = {0x02, 0x2C, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    unsigned char* ptr = data;
+    uint64_t value = 0;
+
+    EXPECT_TRUE(read_nnint(&ptr, data + sizeof(data), &value));
+    EXPECT_EQ(value, 300u);
+    EXPECT_EQ(ptr, data + 3);
+}
+
+TEST_F(BejParserTest, ReadNnintNearBufferEnd) {
+    unsigned char data[] = {0x03, 0x01, 0x02, 0x03};
+    unsigned char* ptr = data;
+    uint64_t value = 0;
+
+    EXPECT_TRUE(read_nnint(&ptr, data + sizeof(data), &value));
+    EXPECT_EQ(value, 0x030201u);
+    EXPECT_EQ(ptr, data + 4);
+}
+
+TEST_F(BejParserTest, ReadNnintTruncated) {
+    unsigned char data[] = {0x04, 0x01, 0x02};
+    unsigned char* ptr = data;
+    uint64_t value = 0;
+
+    EXPECT_FALSE(read_nnint(&ptr, data + sizeof(data), &value));
+    EXPECT_EQ(ptr, data);
+}
+
+TEST_F(BejParserTest, ReadUint64LittleEndian) {
+    unsigned char data[] = {0x01, 0x02, 0x03, 0x04};
+    unsigned char* ptr = data;
+
+    EXPECT_EQ(read_uint64(&ptr, 4, data + sizeof(data)), 0x04030201u);
+    EXPECT_EQ(ptr, data + 4);
+}
+
 // Тест для читання integer
 TEST_F(BejParserTest, ReadInt8) {
     unsigned char data[] = {0x42};
@@ -85,10 +135,31 @@ TEST_F(BejParserTest, ReadStringNullTerminated) {
     free(result);
 }
 
+TEST_F(BejParserTest, ReadStringPastEnd) {
+    unsigned char data[] = {'T', 'e', 's', 't'};
+    unsigned char* ptr = data;
+    EXPECT_EQ(read_str(&ptr, 5, data + sizeof(data)), nullptr);
+    EXPECT_EQ(read_str(&ptr, SIZE_MAX, data + sizeof(data)), nullptr);
+    EXPECT_EQ(read_str(&ptr, 0xFFFFFFFFu, data + sizeof(data)), nullptr);
+    EXPECT_EQ(ptr, data);
+}
+
+TEST_F(BejParserTest, ParseOversizedStringLength) {
+    // Id: String whose length nnint is FF FF FF FF, then Reading: 42
+    unsigned char data[] = {0x01, 0x04, 0x05, 0x04, 0xFF, 0xFF, 0xFF, 0xFF, 'A', 0x00,
+                            0x01, 0x02, 0x03, 0x01, 0x01, 0x2A};
+    struct bej_node* root = parse_sflv_init(data, sizeof(data), nullptr);
+    ASSERT_TRUE(root != nullptr);
+    ASSERT_EQ(root->children_count, 1);
+    EXPECT_EQ(root->children[0]->format, BEJ_FORMAT_STRING);
+    EXPECT_EQ(root->children[0]->value, nullptr);
+    free_bej_node(root);
+}
+
 // Тест для парсинга простих вузлів
 TEST_F(BejParserTest, ParseSimpleIntegerNode) {
     unsigned char data[] = {
-        0x02, 0x03, 0x04, 0x01, 0x02, 0x03, 0x04
+        0x01, 0x02, 0x03, 0x01, 0x04, 0x04, 0x03, 0x02, 0x01
     };
     
     struct bej_node* node = (struct bej_node*)calloc(1, sizeof(struct bej_node));
@@ -106,8 +177,23 @@ TEST_F(BejParserTest, ParseSimpleIntegerNode) {
     free_bej_node(node);
 }
 
+TEST_F(BejParserTest, ParseNegativeIntegerNode) {
+    // Three byte integer -2
+    unsigned char data[] = {0x01, 0x02, 0x03, 0x01, 0x03, 0xFE, 0xFF, 0xFF};
+
+    struct bej_node* node = (struct bej_node*)calloc(1, sizeof(struct bej_node));
+    unsigned char* ptr = data;
+    parse_sflv_recursion(node, &ptr, data + sizeof(data), nullptr, data);
+
+    ASSERT_TRUE(node->value != nullptr);
+    EXPECT_EQ(*(int64_t*)node->value, -2);
+    EXPECT_EQ(ptr, data + sizeof(data));
+
+    free_bej_node(node);
+}
+
 TEST_F(BejParserTest, ParseBooleanNode) {
-    unsigned char data[] = {0x04, 0x06, 0x01, 0x01};
+    unsigned char data[] = {0x01, 0x04, 0x06, 0x01, 0x01, 0x01};
     
     struct bej_node* node = (struct bej_node*)calloc(1, sizeof(struct bej_node));
     unsigned char* ptr = data;
@@ -144,6 +230,25 @@ TEST_F(BejParserTest, LoadMapBasic) {
     remove("test_map.map");
 }
 
+TEST_F(BejParserTest, LoadMapBuildsKeyTokens) {
+    FILE* f = fopen("test_map_keys.map", "w");
+    ASSERT_TRUE(f != nullptr);
+    fprintf(f, "1: CapacityMiB\n2: @odata.id\n");
+    fclose(f);
+
+    size_t count = 0;
+    struct field_map* map = load_map("test_map_keys.map", &count);
+    ASSERT_TRUE(map != nullptr);
+    ASSERT_EQ(count, 2);
+    EXPECT_STREQ(map[0].key, "\"CapacityMiB\": ");
+    EXPECT_EQ(map[0].key_len, 15u);
+    EXPECT_EQ(get_field_entry(2, map, count), &map[1]);
+    EXPECT_EQ(get_field_entry(9, map, count), nullptr);
+
+    free_map(map, count);
+    remove("test_map_keys.map");
+}
+
 TEST_F(BejParserTest, GetFieldNameFound) {
     struct field_map map[] = {
         {1, strdup("CapacityMiB")},
@@ -204,4 +309,137 @@ TEST_F(BejParserTest, MalformedVarint) {
     
     uint64_t result = read_varint_u64(&ptr, end);
     EXPECT_TRUE(result == 0 || ptr == end);
-}
\ No newline at end of file
+}
+// Explicit stack tests
+TEST_F(BejParserTest, ParseNestedWithinDepth) {
+    // Set { Set { Integer 7 } }
+    unsigned char data[] = {0x01, 0x00, 0x01, 0x01, 0x0B,
+                            0x01, 0x02, 0x01, 0x01, 0x06,
+                            0x01, 0x04, 0x03, 0x01, 0x01, 0x07};
+    struct bej_stack stack;
+    ASSERT_TRUE(bej_stack_init(&stack, 2));
+
+    struct bej_node* node = (struct bej_node*)calloc(1, sizeof(struct bej_node));
+    unsigned char* ptr = data;
+    EXPECT_EQ(parse_sflv_stack(node, &ptr, data + sizeof(data), &stack), 0);
+    EXPECT_EQ(ptr, data + sizeof(data));
+    ASSERT_EQ(node->children_count, 1);
+    ASSERT_EQ(node->children[0]->children_count, 1);
+    EXPECT_EQ(*(int8_t*)node->children[0]->children[0]->value, 7);
+
+    free_bej_node(node);
+    bej_stack_free(&stack);
+}
+
+TEST_F(BejParserTest, ParseSkipsBeyondMaxDepth) {
+    // Set { Set { Integer 7 } }, Integer 5 after it
+    unsigned char data[] = {0x01, 0x00, 0x01, 0x01, 0x11,
+                            0x01, 0x02, 0x01, 0x01, 0x06,
+                            0x01, 0x04, 0x03, 0x01, 0x01, 0x07,
+                            0x01, 0x06, 0x03, 0x01, 0x01, 0x05};
+    struct bej_stack stack;
+    ASSERT_TRUE(bej_stack_init(&stack, 1));
+
+    struct bej_node* node = (struct bej_node*)calloc(1, sizeof(struct bej_node));
+    unsigned char* ptr = data;
+    EXPECT_EQ(parse_sflv_stack(node, &ptr, data + sizeof(data), &stack), -1);
+    EXPECT_EQ(ptr, data + sizeof(data));
+    ASSERT_EQ(node->children_count, 2);
+    EXPECT_EQ(node->children[0]->format, BEJ_FORMAT_NULL);
+    EXPECT_EQ(node->children[0]->children_count, 0);
+    EXPECT_EQ(node->children[1]->sequence, 3);
+
+    free_bej_node(node);
+    bej_stack_free(&stack);
+}
+
+TEST_F(BejParserTest, ZeroDepthStackWritesNoFrames) {
+    // Set { Integer 7 } against a caller-built stack with no usable frames
+    unsigned char data[] = {0x01, 0x00, 0x01, 0x01, 0x06,
+                            0x01, 0x02, 0x03, 0x01, 0x01, 0x07};
+    struct bej_frame guard[1] = {};
+    struct bej_stack stack = { guard, 0 };
+    EXPECT_FALSE(bej_stack_init(&stack, 0));
+    stack.frames = guard;
+
+    struct bej_node* node = (struct bej_node*)calloc(1, sizeof(struct bej_node));
+    unsigned char* ptr = data;
+    EXPECT_EQ(parse_sflv_stack(node, &ptr, data + sizeof(data), &stack), -1);
+    EXPECT_EQ(ptr, data + sizeof(data));
+    EXPECT_EQ(node->format, BEJ_FORMAT_NULL);
+    EXPECT_EQ(node->children_count, 0);
+    EXPECT_EQ(guard[0].node, nullptr);
+    free_bej_node(node);
+
+    EXPECT_EQ(parse_sflv_init_stack(data, sizeof(data), &stack), nullptr);
+
+    struct bej_node set = {};
+    set.format = BEJ_FORMAT_SET;
+    struct dynamic_string* str = dynamic_string_init();
+    EXPECT_EQ(bej_node_to_str_stack(&set, str, nullptr, 0, nullptr, 0, &stack), -1);
+    EXPECT_STREQ(str->data, "null");
+    EXPECT_EQ(guard[0].node, nullptr);
+    free(str->data);
+    free(str);
+}
+
+TEST_F(BejParserTest, ParseInitStackPastDepthDecodesNull) {
+    // Sensor { Reading: 42, Status { Health: 1 } }; the stack holds the root and Sensor only
+    unsigned char data[] = {0x01, 0x00, 0x01, 0x01, 0x12,
+                            0x01, 0x02, 0x03, 0x01, 0x01, 0x2A,
+                            0x01, 0x06, 0x01, 0x01, 0x07, 0x01, 0x08, 0x04, 0x01, 0x02, 0x01, 0x01};
+    struct bej_stack stack;
+    ASSERT_TRUE(bej_stack_init(&stack, 2));
+    struct bej_node* root = parse_sflv_init_stack(data, sizeof(data), &stack);
+    bej_stack_free(&stack);
+    ASSERT_TRUE(root != nullptr);
+    ASSERT_EQ(root->children_count, 1);
+    struct bej_node* sensor = root->children[0];
+    ASSERT_EQ(sensor->children_count, 2);
+    EXPECT_EQ(sensor->children[1]->sequence, 3);
+    EXPECT_EQ(sensor->children[1]->format, BEJ_FORMAT_NULL);
+    EXPECT_EQ(sensor->children[1]->children_count, 0);
+
+    // A writer with room to spare still emits null, in every format
+    ASSERT_TRUE(bej_stack_init(&stack, 8));
+    struct dynamic_string* str = dynamic_string_init();
+    EXPECT_EQ(bej_write_node(root, str, BEJ_OUTPUT_JSON, BEJ_OUTPUT_COMPACT, nullptr, 0, &stack), 0);
+    EXPECT_TRUE(strstr(str->data, "\"field_3\":null") != nullptr) << str->data;
+    free(str->data);
+    free(str);
+
+    str = dynamic_string_init();
+    EXPECT_EQ(bej_write_node(root, str, BEJ_OUTPUT_CBOR, BEJ_OUTPUT_INT_KEYS, nullptr, 0, &stack), 0);
+    ASSERT_GT(str->length, 0u);
+    EXPECT_EQ((unsigned char)str->data[str->length - 1], 0xF6);
+    free(str->data);
+    free(str);
+
+    bej_stack_free(&stack);
+    free_bej_node(root);
+}
+
+TEST_F(BejParserTest, ParseInitDeepNestingIsBounded) {
+    // 2000 nested sets, far beyond the default depth
+    std::vector<unsigned char> data = {0x01, 0x00, 0x01, 0x00};
+    for (int i = 1; i < 2000; i++) {
+        std::vector<unsigned char> outer = {0x01, 0x00, 0x01, 0x02};
+        size_t len = data.size();
+        outer.push_back((unsigned char)(len & 0xFF));
+        outer.push_back((unsigned char)(len >> 8));
+        outer.insert(outer.end(), data.begin(), data.end());
+        data.swap(outer);
+    }
+
+    struct bej_node* root = parse_sflv_init(data.data(), data.size(), nullptr);
+    ASSERT_TRUE(root != nullptr);
+    EXPECT_EQ(root->children_count, 1);
+
+    struct dynamic_string* str = dynamic_string_init();
+    parse_bej_node_to_str_recursion(root, str, nullptr, 0, nullptr, 0);
+    EXPECT_TRUE(strstr(str->data, "null") != nullptr);
+
+    free(str->data);
+    free(str);
+    free_bej_node(root);
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include "bej_wrapper.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+static FILE* open_bytes(std::vector<unsigned char>& bytes) {
+    return fmemopen(bytes.data(), bytes.size(), "rb");
+}
+
+// Reading: 42 and Id: "A" as two top-level tuples
+static const unsigned char reading[] = {0x01, 0x02, 0x03, 0x01, 0x01, 0x2A};
+static const unsigned char id[] = {0x01, 0x04, 0x05, 0x01, 0x02, 'A', 0x00};
+
+TEST(BejStreamTest, ConcatenatedRecords) {
+    std::vector<unsigned char> bytes(reading, reading + sizeof(reading));
+    bytes.insert(bytes.end(), id, id + sizeof(id));
+    FILE* f = open_bytes(bytes);
+    ASSERT_TRUE(f != nullptr);
+
+    struct bej_stream s;
+    bej_stream_init(&s, f, BEJ_FRAMING_CONCAT, 0);
+    struct bej_stream_record rec;
+
+    ASSERT_EQ(bej_stream_next(&s, &rec), BEJ_STREAM_RECORD);
+    ASSERT_EQ(rec.size, sizeof(reading));
+    EXPECT_EQ(memcmp(rec.data, reading, sizeof(reading)), 0);
+    EXPECT_FALSE(rec.has_schema);
+
+    ASSERT_EQ(bej_stream_next(&s, &rec), BEJ_STREAM_RECORD);
+    ASSERT_EQ(rec.size, sizeof(id));
+    EXPECT_EQ(rec.offset, sizeof(reading));
+    EXPECT_EQ(memcmp(rec.data, id, sizeof(id)), 0);
+
+    EXPECT_EQ(bej_stream_next(&s, &rec), BEJ_STREAM_END);
+    EXPECT_EQ(s.records, 2u);
+    bej_stream_free(&s);
+    fclose(f);
+}
+
+TEST(BejStreamTest, TruncatedConcatenatedRecord) {
+    std::vector<unsigned char> bytes(reading, reading + sizeof(reading) - 1);
+    FILE* f = open_bytes(bytes);
+    struct bej_stream s;
+    bej_stream_init(&s, f, BEJ_FRAMING_CONCAT, 0);
+    struct bej_stream_record rec;
+    EXPECT_EQ(bej_stream_next(&s, &rec), BEJ_STREAM_TRUNCATED);
+    bej_stream_free(&s);
+    fclose(f);
+}
+
+TEST(BejStreamTest, LengthPrefixedWithSchema) {
+    std::vector<unsigned char> bytes = {sizeof(reading), 0, 0, 0, 7, 0, 0, 0};
+    bytes.insert(bytes.end(), reading, reading + sizeof(reading));
+    bytes.insert(bytes.end(), {sizeof(id), 0, 0, 0, 9, 0, 0, 0});
+    bytes.insert(bytes.end(), id, id + sizeof(id));
+    FILE* f = open_bytes(bytes);
+
+    struct bej_stream s;
+    bej_stream_init(&s, f, BEJ_FRAMING_LENGTH_SCHEMA, 0);
+    struct bej_stream_record rec;
+
+    ASSERT_EQ(bej_stream_next(&s, &rec), BEJ_STREAM_RECORD);
+    EXPECT_TRUE(rec.has_schema);
+    EXPECT_EQ(rec.schema_id, 7u);
+    EXPECT_EQ(rec.size, sizeof(reading));
+
+    ASSERT_EQ(bej_stream_next(&s, &rec), BEJ_STREAM_RECORD);
+    EXPECT_EQ(rec.schema_id, 9u);
+    EXPECT_EQ(memcmp(rec.data, id, sizeof(id)), 0);
+
+    EXPECT_EQ(bej_stream_next(&s, &rec), BEJ_STREAM_END);
+    bej_stream_free(&s);
+    fclose(f);
+}
+
+TEST(BejStreamTest, OversizedRecordIsSkipped) {
+    std::vector<unsigned char> bytes = {sizeof(id), 0, 0, 0};
+    bytes.insert(bytes.end(), id, id + sizeof(id));
+    bytes.insert(bytes.end(), {sizeof(reading), 0, 0, 0});
+    bytes.insert(bytes.end(), reading, reading + sizeof(reading));
+    FILE* f = open_bytes(bytes);
+
+    struct bej_stream s;
+    bej_stream_init(&s, f, BEJ_FRAMING_LENGTH, sizeof(reading));
+    struct bej_stream_record rec;
+
+    EXPECT_EQ(bej_stream_next(&s, &rec), BEJ_STREAM_TOO_LARGE);
+    ASSERT_EQ(bej_stream_next(&s, &rec), BEJ_STREAM_RECORD);
+    EXPECT_EQ(memcmp(rec.data, reading, sizeof(reading)), 0);
+    EXPECT_EQ(bej_stream_next(&s, &rec), BEJ_STREAM_END);
+    bej_stream_free(&s);
+    fclose(f);
+}
+
+TEST(BejStreamTest, CompactRecordsStayOnOneLine) {
+    // Id: "a<LF>b" and Id: "q\"c", concatenated
+    std::vector<unsigned char> bytes = {0x01, 0x04, 0x05, 0x01, 0x04, 'a', '\n', 'b', 0x00,
+                                        0x01, 0x04, 0x05, 0x01, 0x04, 'q', '"', 'c', 0x00};
+    FILE* f = open_bytes(bytes);
+    ASSERT_TRUE(f != nullptr);
+
+    struct field_map map[1] = {};
+    map[0].sequence = 2;
+    map[0].name = strdup("Id");
+
+    struct bej_context* ctx = bej_context_create(BEJ_DEFAULT_MAX_DEPTH, NULL);
+    ASSERT_TRUE(ctx != nullptr);
+    struct bej_stream s;
+    bej_stream_init(&s, f, BEJ_FRAMING_CONCAT, 0);
+    struct bej_stream_record rec;
+
+    // Records are joined the way --stream prints them: one document per line
+    std::string ndjson;
+    while (bej_stream_next(&s, &rec) == BEJ_STREAM_RECORD) {
+        ASSERT_EQ(bej_context_convert(ctx, rec.data, rec.size, BEJ_OUTPUT_JSON, BEJ_OUTPUT_COMPACT, map, 1),
+                  BEJ_CONTEXT_OK);
+        ndjson.append(ctx->out.data, ctx->out.length);
+        ndjson += '\n';
+    }
+    EXPECT_EQ(ndjson, "{\"Id\":\"a\\u000ab\"}\n{\"Id\":\"q\\\"c\"}\n");
+    EXPECT_EQ(std::count(ndjson.begin(), ndjson.end(), '\n'), 2);
+
+    bej_stream_free(&s);
+    bej_context_free(ctx);
+    free(map[0].name);
+    fclose(f);
+}
+
+TEST(BejStreamTest, ZeroLimitStillCapsRecordLength) {
+    // Concatenated header claiming a value of 0xF0 << 56 bytes, then a real record
+    std::vector<unsigned char> bytes = {0x01, 0x02, 0x03, 0x08, 0, 0, 0, 0, 0, 0, 0, 0xF0};
+    FILE* f = open_bytes(bytes);
+    ASSERT_TRUE(f != nullptr);
+
+    struct bej_stream s;
+    bej_stream_init(&s, f, BEJ_FRAMING_CONCAT, 0);
+    EXPECT_EQ(s.max_record, (size_t)BEJ_STREAM_MAX_RECORD_CAP);
+    struct bej_stream_record rec;
+    // Skipping runs into the end of input instead of allocating or looping
+    EXPECT_EQ(bej_stream_next(&s, &rec), BEJ_STREAM_TRUNCATED);
+    bej_stream_free(&s);
+    fclose(f);
+
+    bytes.assign({0x01, 0x02, 0x03, 0x08, 0xF0, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF});
+    f = open_bytes(bytes);
+    bej_stream_init(&s, f, BEJ_FRAMING_CONCAT, SIZE_MAX);
+    EXPECT_EQ(bej_stream_next(&s, &rec), BEJ_STREAM_TRUNCATED);
+    bej_stream_free(&s);
+    fclose(f);
+}
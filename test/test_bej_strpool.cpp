@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include "bej_wrapper.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+TEST(BejStrpoolTest, SameBytesSamePointer) {
+    const char* a = bej_intern("Health", 6);
+    const char* b = bej_intern("HealthRollup", 6);
+    ASSERT_TRUE(a != nullptr);
+    EXPECT_EQ(a, b);
+    EXPECT_STREQ(a, "Health");
+
+    const char* c = bej_intern("HealthRollup", 12);
+    EXPECT_NE(a, c);
+    EXPECT_STREQ(c, "HealthRollup");
+}
+
+TEST(BejStrpoolTest, CountsDistinctStrings) {
+    struct bej_strpool_stats before, after;
+    bej_strpool_get_stats(&before);
+    // Enough distinct strings to force the table to grow
+    for (int round = 0; round < 2; round++)
+        for (int i = 0; i < 3000; i++) {
+            std::string s = "strpool_test_" + std::to_string(i);
+            ASSERT_TRUE(bej_intern(s.c_str(), s.size()) != nullptr);
+        }
+    bej_strpool_get_stats(&after);
+    EXPECT_EQ(after.strings - before.strings, 3000u);
+    EXPECT_EQ(after.lookups - before.lookups, 6000u);
+    EXPECT_EQ(after.hits - before.hits, 3000u);
+}
+
+TEST(BejStrpoolTest, MapsShareNamesAndKeys) {
+    FILE* f = fopen("test_pool_a.map", "w");
+    ASSERT_TRUE(f != nullptr);
+    fprintf(f, "0: Status\n1: Id\n");
+    fclose(f);
+    f = fopen("test_pool_b.map", "w");
+    ASSERT_TRUE(f != nullptr);
+    fprintf(f, "4: Id\n5: Status\n");
+    fclose(f);
+
+    size_t count_a = 0, count_b = 0;
+    struct field_map* a = load_map("test_pool_a.map", &count_a);
+    struct field_map* b = load_map("test_pool_b.map", &count_b);
+    ASSERT_TRUE(a != nullptr);
+    ASSERT_TRUE(b != nullptr);
+
+    EXPECT_EQ(a[0].name, b[1].name);
+    EXPECT_EQ(a[0].key, b[1].key);
+    EXPECT_EQ(a[1].name, b[0].name);
+    EXPECT_STREQ(b[0].key, "\"Id\": ");
+
+    free_map(a, count_a);
+    free_map(b, count_b);
+    remove("test_pool_a.map");
+    remove("test_pool_b.map");
+}
+
+TEST(BejStrpoolTest, FreeMapReleasesHandBuiltStrings) {
+    // Hand-built maps own heap names and tokens, as before the pool existed
+    struct field_map* map = (struct field_map*)calloc(2, sizeof(struct field_map));
+    ASSERT_TRUE(map != nullptr);
+    map[0].sequence = 0;
+    map[0].name = strdup("Sensor");
+    map[1].sequence = 1;
+    map[1].name = strdup("Reading");
+    ASSERT_TRUE(build_field_key(&map[1]));
+    EXPECT_STREQ(map[1].key, "\"Reading\": ");
+    EXPECT_FALSE(bej_strpool_owns(map[0].name));
+    EXPECT_FALSE(bej_strpool_owns(map[1].key));
+    free_map(map, 2);
+
+    const char* pooled = bej_intern("Reading", 7);
+    EXPECT_TRUE(bej_strpool_owns(pooled));
+    EXPECT_FALSE(bej_strpool_owns(nullptr));
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include "bej_wrapper.h"
+
+TEST(BejValidateTest, ValidDocument) {
+    unsigned char data[] = {
+        0x01, 0x00, 0x01, 0x01, 0x12,
+        0x01, 0x02, 0x03, 0x01, 0x01, 0x2A,
+        0x01, 0x06, 0x01, 0x01, 0x07, 0x01, 0x08, 0x04, 0x01, 0x02, 0x01, 0x01
+    };
+    struct bej_validate_error err;
+
+    EXPECT_EQ(bej_validate(data, sizeof(data), nullptr, &err), BEJ_VALID);
+    EXPECT_EQ(err.offset, sizeof(data));
+}
+
+TEST(BejValidateTest, EmptyPayload) {
+    EXPECT_EQ(bej_validate(nullptr, 0, nullptr, nullptr), BEJ_ERR_EMPTY);
+}
+
+TEST(BejValidateTest, NullLengthOverrunsBuffer) {
+    // Null value claiming 16 bytes that are not there
+    unsigned char data[] = {0x01, 0x02, 0x00, 0x01, 0x10};
+    struct bej_validate_error err;
+
+    EXPECT_EQ(bej_validate(data, sizeof(data), nullptr, &err), BEJ_ERR_LENGTH_OVERRUN);
+    EXPECT_EQ(err.offset, 0u);
+}
+
+TEST(BejValidateTest, ChildOverrunsParent) {
+    // Set of 6 bytes whose child claims 2 value bytes after a 5 byte header
+    unsigned char data[] = {0x01, 0x00, 0x01, 0x01, 0x06, 0x01, 0x02, 0x03, 0x01, 0x02, 0x2A, 0x00};
+    struct bej_validate_error err;
+
+    EXPECT_EQ(bej_validate(data, sizeof(data), nullptr, &err), BEJ_ERR_LENGTH_OVERRUN);
+    EXPECT_EQ(err.offset, 5u);
+    EXPECT_EQ(err.depth, 1u);
+}
+
+TEST(BejValidateTest, TruncatedHeader) {
+    unsigned char data[] = {0x01, 0x02, 0x03};
+    struct bej_validate_error err;
+
+    EXPECT_EQ(bej_validate(data, sizeof(data), nullptr, &err), BEJ_ERR_TRUNCATED_HEADER);
+    EXPECT_EQ(err.offset, 0u);
+}
+
+TEST(BejValidateTest, UnknownFormat) {
+    unsigned char data[] = {0x01, 0x02, 0x0C, 0x00};
+    EXPECT_EQ(bej_validate(data, sizeof(data), nullptr, nullptr), BEJ_ERR_BAD_FORMAT);
+}
+
+TEST(BejValidateTest, BadBooleanLength) {
+    unsigned char data[] = {0x01, 0x02, 0x06, 0x01, 0x02, 0x01, 0x01};
+    EXPECT_EQ(bej_validate(data, sizeof(data), nullptr, nullptr), BEJ_ERR_BAD_LENGTH);
+}
+
+TEST(BejValidateTest, DepthLimit) {
+    // Three nested sets
+    unsigned char data[] = {0x01, 0x00, 0x01, 0x01, 0x09,
+                            0x01, 0x02, 0x01, 0x01, 0x04,
+                            0x01, 0x04, 0x01, 0x00};
+    struct bej_validate_limits limits = {2, UINT64_MAX};
+    struct bej_validate_error err;
+
+    EXPECT_EQ(bej_validate(data, sizeof(data), &limits, &err), BEJ_ERR_TOO_DEEP);
+    EXPECT_EQ(err.offset, 10u);
+    limits.max_depth = 3;
+    EXPECT_EQ(bej_validate(data, sizeof(data), &limits, &err), BEJ_VALID);
+}
+
+TEST(BejValidateTest, SequenceRange) {
+    unsigned char data[] = {0x01, 0x0A, 0x03, 0x01, 0x01, 0x2A};
+    struct bej_validate_limits limits = {0, 4};
+
+    EXPECT_EQ(bej_validate(data, sizeof(data), &limits, nullptr), BEJ_ERR_BAD_SEQUENCE);
+    limits.max_sequence = 5;
+    EXPECT_EQ(bej_validate(data, sizeof(data), &limits, nullptr), BEJ_VALID);
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include "bej_wrapper.h"
+#include <string.h>
+#include <vector>
+
+class BinaryWriterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        out = dynamic_string_init();
+        ASSERT_TRUE(bej_stack_init(&stack, BEJ_DEFAULT_MAX_DEPTH));
+
+        reading.format = 3; // INTEGER
+        reading.length = 1;
+        reading.sequence = 1;
+        reading.value = &reading_value;
+
+        id.format = 5; // STRING
+        id.sequence = 2;
+        id.value = (void*)"A";
+
+        set_children[0] = &reading;
+        set_children[1] = &id;
+        set.format = 1; // SET
+        set.children = set_children;
+        set.children_count = 2;
+
+        map[0].sequence = 1;
+        map[0].name = (char*)"Reading";
+        map[1].sequence = 2;
+        map[1].name = (char*)"Id";
+    }
+
+    void TearDown() override {
+        bej_stack_free(&stack);
+        free(out->data);
+        free(out);
+    }
+
+    std::vector<unsigned char> bytes() const {
+        return std::vector<unsigned char>(out->data, out->data + out->length);
+    }
+
+    struct dynamic_string* out;
+    struct bej_stack stack;
+    int8_t reading_value = 42;
+    struct bej_node reading = {};
+    struct bej_node id = {};
+    struct bej_node* set_children[2];
+    struct bej_node set = {};
+    struct field_map map[2] = {};
+};
+
+TEST_F(BinaryWriterTest, CborMapWithNames) {
+    EXPECT_EQ(bej_write_node(&set, out, BEJ_OUTPUT_CBOR, 0, map, 2, &stack), 0);
+    std::vector<unsigned char> expected = {
+        0xA2,
+        0x67, 'R', 'e', 'a', 'd', 'i', 'n', 'g', 0x18, 0x2A,
+        0x62, 'I', 'd', 0x61, 'A'
+    };
+    EXPECT_EQ(bytes(), expected);
+}
+
+TEST_F(BinaryWriterTest, MsgpackMapWithNames) {
+    EXPECT_EQ(bej_write_node(&set, out, BEJ_OUTPUT_MSGPACK, 0, map, 2, &stack), 0);
+    std::vector<unsigned char> expected = {
+        0x82,
+        0xA7, 'R', 'e', 'a', 'd', 'i', 'n', 'g', 0x2A,
+        0xA2, 'I', 'd', 0xA1, 'A'
+    };
+    EXPECT_EQ(bytes(), expected);
+}
+
+TEST_F(BinaryWriterTest, IntegerKeys) {
+    EXPECT_EQ(bej_write_node(&set, out, BEJ_OUTPUT_CBOR, BEJ_OUTPUT_INT_KEYS, map, 2, &stack), 0);
+    std::vector<unsigned char> expected = {0xA2, 0x01, 0x18, 0x2A, 0x02, 0x61, 'A'};
+    EXPECT_EQ(bytes(), expected);
+}
+
+TEST_F(BinaryWriterTest, NegativeIntegers) {
+    int8_t small = -1;
+    int16_t large = -300;
+    struct bej_node a = {};
+    a.format = 3;
+    a.length = 1;
+    a.value = &small;
+    struct bej_node b = {};
+    b.format = 3;
+    b.length = 2;
+    b.value = &large;
+
+    struct bej_node* children[] = {&a, &b};
+    struct bej_node arr = {};
+    arr.format = 2; // ARRAY
+    arr.children = children;
+    arr.children_count = 2;
+
+    bej_write_node(&arr, out, BEJ_OUTPUT_CBOR, 0, nullptr, 0, &stack);
+    std::vector<unsigned char> cbor = {0x82, 0x20, 0x39, 0x01, 0x2B};
+    EXPECT_EQ(bytes(), cbor);
+
+    out->length = 0;
+    bej_write_node(&arr, out, BEJ_OUTPUT_MSGPACK, 0, nullptr, 0, &stack);
+    std::vector<unsigned char> msgpack = {0x92, 0xFF, 0xD1, 0xFE, 0xD4};
+    EXPECT_EQ(bytes(), msgpack);
+}
+
+TEST_F(BinaryWriterTest, BooleansAndNull) {
+    int yes = 1;
+    int no = 0;
+    struct bej_node t = {};
+    t.format = 6;
+    t.value = &yes;
+    struct bej_node f = {};
+    f.format = 6;
+    f.value = &no;
+    struct bej_node n = {};
+    n.format = 0;
+
+    struct bej_node* children[] = {&t, &f, &n};
+    struct bej_node arr = {};
+    arr.format = 2; // ARRAY
+    arr.children = children;
+    arr.children_count = 3;
+
+    bej_write_node(&arr, out, BEJ_OUTPUT_CBOR, 0, nullptr, 0, &stack);
+    std::vector<unsigned char> cbor = {0x83, 0xF5, 0xF4, 0xF6};
+    EXPECT_EQ(bytes(), cbor);
+
+    out->length = 0;
+    bej_write_node(&arr, out, BEJ_OUTPUT_MSGPACK, 0, nullptr, 0, &stack);
+    std::vector<unsigned char> msgpack = {0x93, 0xC3, 0xC2, 0xC0};
+    EXPECT_EQ(bytes(), msgpack);
+}
+
+TEST_F(BinaryWriterTest, JsonThroughWriterInterface) {
+    EXPECT_EQ(bej_write_node(&set, out, BEJ_OUTPUT_JSON, 0, map, 2, &stack), 0);
+    EXPECT_STREQ(out->data, "{\n  \"Reading\": 42,\n  \"Id\": \"A\"\n}");
+}
@@ -0,0 +1,38 @@
+#ifndef TEST_FIXTURES_H
+#define TEST_FIXTURES_H
+
+#include <gtest/gtest.h>
+#include "bej_wrapper.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** Number of entries in the sample Sensor dictionary */
+static const size_t sensor_map_count = 5;
+
+/** Fixture providing the Sensor dictionary used by the sample documents */
+class SensorMapTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const char* names[] = {"Sensor", "Reading", "Id", "Status", "Health"};
+        for (size_t i = 0; i < sensor_map_count; i++) {
+            map[i].sequence = i;
+            map[i].name = strdup(names[i]);
+        }
+    }
+
+    void TearDown() override {
+        for (size_t i = 0; i < sensor_map_count; i++) free(map[i].name);
+    }
+
+    struct field_map map[sensor_map_count] = {};
+};
+
+// Sensor { Reading: 42, Id: "A", Status { Health: 1 } }
+static unsigned char sensor_doc[] = {
+    0x01, 0x00, 0x01, 0x01, 0x18,
+    0x01, 0x02, 0x03, 0x01, 0x01, 0x2A,
+    0x01, 0x04, 0x05, 0x01, 0x01, 'A',
+    0x01, 0x06, 0x01, 0x01, 0x07, 0x01, 0x08, 0x04, 0x01, 0x02, 0x01, 0x01
+};
+
+#endif // TEST_FIXTURES_H
@@ -65,6 +65,17 @@ TEST_F(JsonWriterTest, FormatString) {
     free(node.value);
 }
 
+TEST_F(JsonWriterTest, FormatStringEscaped) {
+    struct bej_node node = {};
+    node.format = 5; // STRING
+    node.value = strdup("a\"b\\c\n\x01" "d");
+
+    parse_bej_node_to_str_recursion(&node, json_str, "test_str", 0, nullptr, 0);
+    EXPECT_STREQ(json_str->data, "\"test_str\": \"a\\\"b\\\\c\\u000a\\u0001d\"");
+
+    free(node.value);
+}
+
 TEST_F(JsonWriterTest, FormatBooleanTrue) {
     struct bej_node node = {};
     node.format = 6; // BOOLEAN
@@ -97,6 +108,7 @@ TEST_F(JsonWriterTest, FormatSetWithMap) {
     struct bej_node* child1 = (struct bej_node*)calloc(1, sizeof(struct bej_node));
     child1->format = 3; // INTEGER
     child1->sequence = 1;
+    child1->length = 4;
     int value1 = 100;
     child1->value = &value1;
     
@@ -128,7 +140,9 @@ TEST_F(JsonWriterTest, FormatSetWithMap) {
     free(child2->value);
     free(child1);
     free(child2);
-    free_map(map, 2);
+    for (size_t i = 0; i < 2; i++) {
+        free(map[i].name);
+    }
 }
 
 TEST_F(JsonWriterTest, UnknownFormat) {
@@ -137,4 +151,135 @@ TEST_F(JsonWriterTest, UnknownFormat) {
     
     parse_bej_node_to_str_recursion(&node, json_str, "unknown", 0, nullptr, 0);
     EXPECT_STREQ(json_str->data, "\"unknown\": \"<unknown>\"");
-}
\ No newline at end of file
+}
+TEST_F(JsonWriterTest, NestedContainersIterative) {
+    struct bej_node leaf = {};
+    leaf.format = 3; // INTEGER
+    leaf.length = 1;
+    int8_t value = 7;
+    leaf.value = &value;
+
+    struct bej_node* arr_children[] = {&leaf};
+    struct bej_node arr = {};
+    arr.format = 2; // ARRAY
+    arr.children = arr_children;
+    arr.children_count = 1;
+    arr.sequence = 1;
+
+    struct bej_node empty = {};
+    empty.format = 1; // SET
+    empty.sequence = 2;
+
+    struct bej_node* set_children[] = {&arr, &empty};
+    struct bej_node set = {};
+    set.format = 1; // SET
+    set.children = set_children;
+    set.children_count = 2;
+
+    parse_bej_node_to_str_recursion(&set, json_str, nullptr, 0, nullptr, 0);
+    EXPECT_STREQ(json_str->data,
+                 "{\n  \"field_1\": [\n    7\n  ],\n  \"field_2\": {\n  }\n}");
+}
+
+TEST_F(JsonWriterTest, DepthLimitWritesNull) {
+    struct bej_node inner = {};
+    inner.format = 1; // SET
+    inner.sequence = 1;
+
+    struct bej_node* children[] = {&inner};
+    struct bej_node outer = {};
+    outer.format = 1; // SET
+    outer.children = children;
+    outer.children_count = 1;
+
+    struct bej_frame frames[1];
+    struct bej_stack stack = {frames, 1};
+    EXPECT_EQ(bej_node_to_str_stack(&outer, json_str, nullptr, 0, nullptr, 0, &stack), -1);
+    EXPECT_STREQ(json_str->data, "{\n  \"field_1\": null\n}");
+}
+
+TEST_F(JsonWriterTest, PrebuiltKeyTokenEscaped) {
+    struct field_map map[1] = {};
+    map[0].sequence = 3;
+    map[0].name = strdup("Say \"hi\"");
+    ASSERT_TRUE(build_field_key(&map[0]));
+    EXPECT_STREQ(map[0].key, "\"Say \\\"hi\\\"\": ");
+    EXPECT_EQ(map[0].key_len, strlen(map[0].key));
+
+    struct bej_node member = {};
+    member.format = 0; // NULL
+    member.sequence = 3;
+
+    struct bej_node* children[] = {&member};
+    struct bej_node set = {};
+    set.format = 1; // SET
+    set.children = children;
+    set.children_count = 1;
+
+    parse_bej_node_to_str_recursion(&set, json_str, nullptr, 0, map, 1);
+    EXPECT_STREQ(json_str->data, "{\n  \"Say \\\"hi\\\"\": null\n}");
+
+    free(map[0].name);
+    free(map[0].key);
+}
+
+TEST_F(JsonWriterTest, NameWithoutTokenEscaped) {
+    // Hand-built entry with no prebuilt key token
+    struct field_map map[1] = {};
+    map[0].sequence = 3;
+    map[0].name = strdup("Say \"hi\"\n");
+
+    struct bej_node member = {};
+    member.format = 0; // NULL
+    member.sequence = 3;
+
+    struct bej_node* children[] = {&member};
+    struct bej_node set = {};
+    set.format = 1; // SET
+    set.children = children;
+    set.children_count = 1;
+
+    parse_bej_node_to_str_recursion(&set, json_str, "Root\"", 0, map, 1);
+    EXPECT_STREQ(json_str->data, "\"Root\\\"\": {\n  \"Say \\\"hi\\\"\\u000a\": null\n}");
+
+    free(map[0].name);
+}
+
+TEST_F(JsonWriterTest, CompactOutput) {
+    struct field_map map[1] = {};
+    map[0].sequence = 1;
+    map[0].name = strdup("Reading");
+    ASSERT_TRUE(build_field_key(&map[0]));
+
+    struct bej_node leaf = {};
+    leaf.format = 3; // INTEGER
+    leaf.length = 1;
+    leaf.sequence = 1;
+    int8_t value = 7;
+    leaf.value = &value;
+
+    struct bej_node* arr_children[] = {&leaf, &leaf};
+    struct bej_node arr = {};
+    arr.format = 2; // ARRAY
+    arr.children = arr_children;
+    arr.children_count = 2;
+    arr.sequence = 2;
+
+    struct bej_node empty = {};
+    empty.format = 1; // SET
+    empty.sequence = 3;
+
+    struct bej_node* set_children[] = {&leaf, &arr, &empty};
+    struct bej_node set = {};
+    set.format = 1; // SET
+    set.children = set_children;
+    set.children_count = 3;
+
+    struct bej_frame frames[4];
+    struct bej_stack stack = {frames, 4};
+    EXPECT_EQ(bej_write_node(&set, json_str, BEJ_OUTPUT_JSON, BEJ_OUTPUT_COMPACT, map, 1, &stack), 0);
+    EXPECT_STREQ(json_str->data, "{\"Reading\":7,\"field_2\":[7,7],\"field_3\":{}}");
+
+    free(map[0].name);
+    free(map[0].key);
+}